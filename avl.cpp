@@ -4,26 +4,266 @@
 
 #include <iostream>
 #include <algorithm>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <climits>
+#include <new>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <atomic>
+#include <type_traits>
 
 using namespace std;
 
 
+// Default aggregate: the sum of the keys. Any monoid works, given as a
+// value_type with identity(), lift(key) and an associative combine(a, b);
+// combine is always applied in key order, so it need not commute. The node
+// pool reuses and frees nodes without destroying them, so value_type must
+// be trivially destructible.
+struct SumMonoid {
+    typedef long long value_type;
+    
+    static value_type identity() {
+        return 0;
+    }
+    
+    static value_type lift(int key) {
+        return key;
+    }
+    
+    static value_type combine(value_type a, value_type b) {
+        return a + b;
+    }
+};
+
+
+template<typename Monoid>
 class Node {
+    static_assert(is_trivially_destructible<typename Monoid::value_type>::value,
+                  "NodePool never runs node destructors, so the aggregate must not need one");
+    
 public:
     int key;
     Node* left;
     Node* right;
     int height;
+    int size;
+    typename Monoid::value_type aggregate;
+    
+    Node(int k) : key(k), left(nullptr), right(nullptr), height(1), size(1), aggregate(Monoid::lift(k)) {}
+};
+
+// Nodes are carved from chunks owned by the pool and recycled through a
+// free list linked by left, so the tree's nodes are released a chunk at a
+// time when the pool goes away. Whole subtrees can be released in O(1);
+// their nodes are taken apart one at a time as allocate() reuses them.
+template<typename NodeType>
+class NodePool {
+private:
+    static const int CHUNK_NODES = 4096;
+    
+    vector<NodeType*> chunks;
+    NodeType* freeList;
+    int usedInChunk;
+    vector<NodeType*> discarded;
+    
+public:
+    NodePool() : freeList(nullptr), usedInChunk(CHUNK_NODES) {}
+    
+    ~NodePool() {
+        for (NodeType* chunk : chunks) {
+            ::operator delete(chunk);
+        }
+    }
+    
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+    
+    
+    NodeType* allocate(int key) {
+        NodeType* slot;
+        if (freeList != nullptr) {
+            slot = freeList;
+            freeList = freeList->left;
+        } else if (!discarded.empty()) {
+            slot = discarded.back();
+            discarded.pop_back();
+            if (slot->left != nullptr) {
+                discarded.push_back(slot->left);
+            }
+            if (slot->right != nullptr) {
+                discarded.push_back(slot->right);
+            }
+        } else {
+            if (usedInChunk == CHUNK_NODES) {
+                chunks.push_back(static_cast<NodeType*>(::operator new(sizeof(NodeType) * CHUNK_NODES)));
+                usedInChunk = 0;
+            }
+            slot = chunks.back() + usedInChunk++;
+        }
+        return new (slot) NodeType(key);
+    }
+    
+    
+    void release(NodeType* node) {
+        node->left = freeList;
+        freeList = node;
+    }
+    
+    
+    void releaseTree(NodeType* root) {
+        if (root != nullptr) {
+            discarded.push_back(root);
+        }
+    }
+    
+    
+    // Take over every chunk of other, leaving it empty. Its chunks go in
+    // front so the chunk being bump-allocated stays last.
+    void absorb(NodePool& other) {
+        chunks.insert(chunks.begin(), other.chunks.begin(), other.chunks.end());
+        other.chunks.clear();
+        other.usedInChunk = CHUNK_NODES;
+        
+        while (other.freeList != nullptr) {
+            NodeType* node = other.freeList;
+            other.freeList = node->left;
+            release(node);
+        }
+        discarded.insert(discarded.end(), other.discarded.begin(), other.discarded.end());
+        other.discarded.clear();
+    }
+};
+
+
+// Fork-join pool for the bulk tree operations. fork() runs one half on the
+// calling thread and queues the other; while waiting, the caller runs
+// queued tasks itself, so nested forks never block a worker.
+class TaskPool {
+private:
+    vector<thread> workers;
+    deque<function<void()>> tasks;
+    mutex lock;
+    condition_variable ready;
+    bool stopping;
+    
+    
+    bool runOne(bool newest) {
+        function<void()> task;
+        {
+            lock_guard<mutex> guard(lock);
+            if (tasks.empty()) {
+                return false;
+            }
+            if (newest) {
+                task = move(tasks.back());
+                tasks.pop_back();
+            } else {
+                task = move(tasks.front());
+                tasks.pop_front();
+            }
+        }
+        task();
+        return true;
+    }
+    
+public:
+    explicit TaskPool(unsigned threads) : stopping(false) {
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this]() {
+                for (;;) {
+                    function<void()> task;
+                    {
+                        unique_lock<mutex> guard(lock);
+                        ready.wait(guard, [this]() { return stopping || !tasks.empty(); });
+                        if (tasks.empty()) {
+                            return;
+                        }
+                        task = move(tasks.front());
+                        tasks.pop_front();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+    
+    ~TaskPool() {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+    
+    
+    static TaskPool& shared() {
+        static TaskPool pool(max(1u, thread::hardware_concurrency()));
+        return pool;
+    }
+    
+    
+    unsigned threads() {
+        return static_cast<unsigned>(workers.size()) + 1;
+    }
+    
     
-    Node(int k) : key(k), left(nullptr), right(nullptr), height(1) {}
+    // Run first and second, possibly in parallel, returning once both are done
+    template<typename F, typename G>
+    void fork(F first, G second) {
+        if (workers.empty()) {
+            first();
+            second();
+            return;
+        }
+        
+        atomic<bool> done(false);
+        {
+            lock_guard<mutex> guard(lock);
+            tasks.emplace_back([&second, &done]() {
+                second();
+                done.store(true, memory_order_release);
+            });
+        }
+        ready.notify_one();
+        
+        first();
+        while (!done.load(memory_order_acquire)) {
+            if (!runOne(true)) {
+                this_thread::yield();
+            }
+        }
+    }
 };
 
+
+template<typename Monoid = SumMonoid>
 class AVLTree {
 private:
-    Node* root;
+    typedef Node<Monoid> NodeType;
+    typedef typename Monoid::value_type Aggregate;
+    
+    // An AVL tree of n nodes is under 1.45 log2(n) tall
+    static const int MAX_HEIGHT = 64;
     
+    // Bulk operations fork only above this many nodes
+    static const int PARALLEL_GRAIN = 1 << 14;
     
-    int height(Node* node) {
+    NodeType* root;
+    NodePool<NodeType> pool;
+    
+    
+    int height(NodeType* node) {
         if (node == nullptr) {
             return 0;
         }
@@ -31,7 +271,25 @@ private:
     }
     
     
-    int getBalanceFactor(Node* node) {
+    static int size(NodeType* node) {
+        return node == nullptr ? 0 : node->size;
+    }
+    
+    static Aggregate aggregate(NodeType* node) {
+        return node == nullptr ? Monoid::identity() : node->aggregate;
+    }
+    
+    
+    // Recompute height, size and aggregate from the children
+    void update(NodeType* node) {
+        node->height = max(height(node->left), height(node->right)) + 1;
+        node->size = size(node->left) + size(node->right) + 1;
+        node->aggregate = Monoid::combine(Monoid::combine(aggregate(node->left), Monoid::lift(node->key)),
+                                          aggregate(node->right));
+    }
+    
+    
+    int getBalanceFactor(NodeType* node) {
         if (node == nullptr) {
             return 0;
         }
@@ -39,178 +297,300 @@ private:
     }
     
     
-    Node* rightRotate(Node* y) {
-        Node* x = y->left;
-        Node* T2 = x->right;
+    NodeType* rightRotate(NodeType* y) {
+        NodeType* x = y->left;
+        NodeType* T2 = x->right;
         
         
         x->right = y;
         y->left = T2;
         
         
-        y->height = max(height(y->left), height(y->right)) + 1;
-        x->height = max(height(x->left), height(x->right)) + 1;
+        update(y);
+        update(x);
         
         
         return x;
     }
     
     
-    Node* leftRotate(Node* x) {
-        Node* y = x->right;
-        Node* T2 = y->left;
+    NodeType* leftRotate(NodeType* x) {
+        NodeType* y = x->right;
+        NodeType* T2 = y->left;
         
         
         y->left = x;
         x->right = T2;
         
         
-        x->height = max(height(x->left), height(x->right)) + 1;
-        y->height = max(height(y->left), height(y->right)) + 1;
+        update(x);
+        update(y);
         
         
         return y;
     }
     
     
-    Node* insertNode(Node* node, int key) {
-        
-        if (node == nullptr) {
-            return new Node(key);
-        }
-        
-        if (key < node->key) {
-            node->left = insertNode(node->left, key);
-        } else if (key > node->key) {
-            node->right = insertNode(node->right, key);
-        } else {
-            
-            return node;
-        }
-        
-        
-        node->height = 1 + max(height(node->left), height(node->right));
+    // Restore the AVL property at node after one of its subtrees changed
+    // height by one, returning the new root of the subtree
+    NodeType* rebalance(NodeType* node) {
+        update(node);
         
         
         int balance = getBalanceFactor(node);
         
         
-        if (balance > 1 && key < node->left->key) {
+        if (balance > 1) {
+            if (getBalanceFactor(node->left) < 0) {
+                node->left = leftRotate(node->left);
+            }
             return rightRotate(node);
         }
         
         
-        if (balance < -1 && key > node->right->key) {
+        if (balance < -1) {
+            if (getBalanceFactor(node->right) > 0) {
+                node->right = rightRotate(node->right);
+            }
             return leftRotate(node);
         }
         
-        
-        if (balance > 1 && key > node->left->key) {
-            node->left = leftRotate(node->left);
-            return rightRotate(node);
+        return node;
+    }
+    
+    
+    // Walk back up the links recorded on the way down, rebalancing each
+    // subtree. Once a subtree comes out at its old height nothing above it
+    // needs rotating, and the rest of the path only refreshes sizes and
+    // aggregates.
+    void retrace(NodeType*** path, int depth) {
+        while (depth > 0) {
+            NodeType** link = path[--depth];
+            int oldHeight = (*link)->height;
+            
+            *link = rebalance(*link);
+            
+            if ((*link)->height == oldHeight) {
+                break;
+            }
         }
         
-        
-        if (balance < -1 && key < node->right->key) {
-            node->right = rightRotate(node->right);
-            return leftRotate(node);
+        while (depth > 0) {
+            update(*path[--depth]);
         }
-        
-        
-        return node;
     }
     
     
-    Node* minValueNode(Node* node) {
-        Node* current = node;
-        
-        
-        while (current->left != nullptr) {
-            current = current->left;
+    // Tree of left's keys, mid and right's keys, where every key of left is
+    // below mid's and every key of right above. Descends the taller side's
+    // spine to a subtree of matching height, so it costs O(|h(left) - h(right)|).
+    NodeType* join(NodeType* left, NodeType* mid, NodeType* right) {
+        if (height(left) > height(right) + 1) {
+            left->right = join(left->right, mid, right);
+            return rebalance(left);
+        }
+        if (height(right) > height(left) + 1) {
+            right->left = join(left, mid, right->left);
+            return rebalance(right);
         }
         
-        return current;
+        mid->left = left;
+        mid->right = right;
+        update(mid);
+        return mid;
     }
     
     
-    Node* deleteNode(Node* root, int key) {
-        
-        if (root == nullptr) {
-            return root;
+    NodeType* splitLast(NodeType* node, NodeType*& last) {
+        if (node->right == nullptr) {
+            last = node;
+            return node->left;
         }
         
-        
-        
-        if (key < root->key) {
-            root->left = deleteNode(root->left, key);
+        NodeType* rest = splitLast(node->right, last);
+        return join(node->left, node, rest);
+    }
+    
+    
+    // join without a middle key
+    NodeType* join2(NodeType* left, NodeType* right) {
+        if (left == nullptr) {
+            return right;
         }
         
-        
-        else if (key > root->key) {
-            root->right = deleteNode(root->right, key);
+        NodeType* last;
+        NodeType* rest = splitLast(left, last);
+        return join(rest, last, right);
+    }
+    
+    
+    // Split node's tree into the keys below key and the keys above it,
+    // returning the node holding key itself, or nullptr
+    NodeType* split(NodeType* node, int key, NodeType*& lower, NodeType*& upper) {
+        if (node == nullptr) {
+            lower = upper = nullptr;
+            return nullptr;
         }
         
-        else {
-            
-            if (root->left == nullptr) {
-                Node* temp = root->right;
-                delete root;
-                return temp;
-            } else if (root->right == nullptr) {
-                Node* temp = root->left;
-                delete root;
-                return temp;
-            }
-            
-            
-            
-            Node* temp = minValueNode(root->right);
-            
-            
-            root->key = temp->key;
-            
-            
-            root->right = deleteNode(root->right, temp->key);
+        NodeType* left = node->left;
+        NodeType* right = node->right;
+        if (key < node->key) {
+            NodeType* found = split(left, key, lower, upper);
+            upper = join(upper, node, right);
+            return found;
+        }
+        if (key > node->key) {
+            NodeType* found = split(right, key, lower, upper);
+            lower = join(left, node, lower);
+            return found;
         }
         
+        lower = left;
+        upper = right;
+        return node;
+    }
+    
+    
+    // Run both halves of a bulk operation, forking when the inputs are
+    // large. Each half collects the subtrees it discards separately.
+    template<typename F, typename G>
+    void forkIf(bool large, vector<NodeType*>& discarded, F first, G second) {
+        if (!large) {
+            first(discarded);
+            second(discarded);
+            return;
+        }
         
-        if (root == nullptr) {
-            return root;
+        vector<NodeType*> secondDiscarded;
+        TaskPool::shared().fork([&]() { first(discarded); },
+                                [&]() { second(secondDiscarded); });
+        discarded.insert(discarded.end(), secondDiscarded.begin(), secondDiscarded.end());
+    }
+    
+    
+    static NodeType* detach(NodeType* node) {
+        node->left = node->right = nullptr;
+        return node;
+    }
+    
+    
+    // Split b around a's root, combine the halves recursively and join the
+    // results back around that root: O(m log(n/m + 1)) work, O(log^2 n) depth.
+    // Nodes left out of the result are appended to discarded.
+    NodeType* unite(NodeType* a, NodeType* b, vector<NodeType*>& discarded) {
+        if (a == nullptr) {
+            return b;
+        }
+        if (b == nullptr) {
+            return a;
         }
         
+        NodeType* lowerB;
+        NodeType* upperB;
+        NodeType* duplicate = split(b, a->key, lowerB, upperB);
+        if (duplicate != nullptr) {
+            discarded.push_back(detach(duplicate));
+        }
         
-        root->height = 1 + max(height(root->left), height(root->right));
+        NodeType* left;
+        NodeType* right;
+        forkIf(size(a) + size(b) > PARALLEL_GRAIN, discarded,
+               [&](vector<NodeType*>& d) { left = unite(a->left, lowerB, d); },
+               [&](vector<NodeType*>& d) { right = unite(a->right, upperB, d); });
+        return join(left, a, right);
+    }
+    
+    
+    NodeType* intersect(NodeType* a, NodeType* b, vector<NodeType*>& discarded) {
+        if (a == nullptr || b == nullptr) {
+            if (a != nullptr || b != nullptr) {
+                discarded.push_back(a != nullptr ? a : b);
+            }
+            return nullptr;
+        }
         
+        NodeType* lowerB;
+        NodeType* upperB;
+        NodeType* match = split(b, a->key, lowerB, upperB);
         
-        int balance = getBalanceFactor(root);
+        NodeType* left;
+        NodeType* right;
+        forkIf(size(a) + size(b) > PARALLEL_GRAIN, discarded,
+               [&](vector<NodeType*>& d) { left = intersect(a->left, lowerB, d); },
+               [&](vector<NodeType*>& d) { right = intersect(a->right, upperB, d); });
         
+        if (match != nullptr) {
+            discarded.push_back(detach(match));
+            return join(left, a, right);
+        }
+        discarded.push_back(detach(a));
+        return join2(left, right);
+    }
+    
+    
+    // Keys of a that are not in b
+    NodeType* subtract(NodeType* a, NodeType* b, vector<NodeType*>& discarded) {
+        if (a == nullptr || b == nullptr) {
+            if (b != nullptr) {
+                discarded.push_back(b);
+            }
+            return a;
+        }
         
-        if (balance > 1 && getBalanceFactor(root->left) >= 0) {
-            return rightRotate(root);
+        NodeType* lowerA;
+        NodeType* upperA;
+        NodeType* match = split(a, b->key, lowerA, upperA);
+        if (match != nullptr) {
+            discarded.push_back(detach(match));
         }
         
+        NodeType* left;
+        NodeType* right;
+        forkIf(size(a) + size(b) > PARALLEL_GRAIN, discarded,
+               [&](vector<NodeType*>& d) { left = subtract(lowerA, b->left, d); },
+               [&](vector<NodeType*>& d) { right = subtract(upperA, b->right, d); });
         
-        if (balance > 1 && getBalanceFactor(root->left) < 0) {
-            root->left = leftRotate(root->left);
-            return rightRotate(root);
+        discarded.push_back(detach(b));
+        return join2(left, right);
+    }
+    
+    
+    // Perfectly balanced tree over nodes[lo, hi), which are already in key order
+    NodeType* build(NodeType** nodes, int lo, int hi) {
+        if (lo == hi) {
+            return nullptr;
         }
         
-        
-        if (balance < -1 && getBalanceFactor(root->right) <= 0) {
-            return leftRotate(root);
+        int mid = lo + (hi - lo) / 2;
+        NodeType* node = nodes[mid];
+        if (hi - lo > PARALLEL_GRAIN) {
+            TaskPool::shared().fork([&]() { node->left = build(nodes, lo, mid); },
+                                    [&]() { node->right = build(nodes, mid + 1, hi); });
+        } else {
+            node->left = build(nodes, lo, mid);
+            node->right = build(nodes, mid + 1, hi);
         }
+        update(node);
+        return node;
+    }
+    
+    
+    // Combine with other's tree through op, taking over other's nodes
+    template<typename Op>
+    void combine(AVLTree& other, Op op) {
+        pool.absorb(other.pool);
         
+        vector<NodeType*> discarded;
+        root = op(root, other.root, discarded);
+        other.root = nullptr;
         
-        if (balance < -1 && getBalanceFactor(root->right) > 0) {
-            root->right = rightRotate(root->right);
-            return leftRotate(root);
+        for (NodeType* subtree : discarded) {
+            pool.releaseTree(subtree);
         }
-        
-        return root;
     }
     
     
-    void inOrder(Node* root) {
+    void inOrder(NodeType* root) {
         if (root == nullptr) {
             return;
         }
@@ -221,7 +601,7 @@ private:
     }
     
     
-    void preOrder(Node* root) {
+    void preOrder(NodeType* root) {
         if (root == nullptr) {
             return;
         }
@@ -231,17 +611,95 @@ private:
         preOrder(root->right);
     }
     
+    
+    template<typename F>
+    void rangeFrom(NodeType* root, int lo, int hi, F& visit) {
+        if (root == nullptr) {
+            return;
+        }
+        
+        if (lo < root->key) {
+            rangeFrom(root->left, lo, hi, visit);
+        }
+        if (lo <= root->key && root->key < hi) {
+            visit(root->key);
+        }
+        if (root->key < hi) {
+            rangeFrom(root->right, lo, hi, visit);
+        }
+    }
+    
+    
 public:
     AVLTree() : root(nullptr) {}
     
+    AVLTree(const AVLTree&) = delete;
+    AVLTree& operator=(const AVLTree&) = delete;
+    
+    
+    bool search(int key) {
+        NodeType* current = root;
+        while (current != nullptr && current->key != key) {
+            current = key < current->key ? current->left : current->right;
+        }
+        return current != nullptr;
+    }
+    
     
     void insert(int key) {
-        root = insertNode(root, key);
+        NodeType** path[MAX_HEIGHT];
+        int depth = 0;
+        
+        
+        NodeType** link = &root;
+        while (*link != nullptr) {
+            NodeType* node = *link;
+            if (key == node->key) {
+                return;
+            }
+            
+            path[depth++] = link;
+            link = key < node->key ? &node->left : &node->right;
+        }
+        
+        *link = pool.allocate(key);
+        retrace(path, depth);
     }
     
     
     void remove(int key) {
-        root = deleteNode(root, key);
+        NodeType** path[MAX_HEIGHT];
+        int depth = 0;
+        
+        
+        NodeType** link = &root;
+        while (*link != nullptr && (*link)->key != key) {
+            path[depth++] = link;
+            link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+        }
+        
+        if (*link == nullptr) {
+            return;
+        }
+        
+        
+        NodeType* target = *link;
+        if (target->left != nullptr && target->right != nullptr) {
+            // Take the in-order successor's key and unlink the successor
+            path[depth++] = link;
+            link = &target->right;
+            while ((*link)->left != nullptr) {
+                path[depth++] = link;
+                link = &(*link)->left;
+            }
+            
+            target->key = (*link)->key;
+            target = *link;
+        }
+        
+        *link = target->left != nullptr ? target->left : target->right;
+        pool.release(target);
+        retrace(path, depth);
     }
     
     
@@ -257,31 +715,1240 @@ public:
         preOrder(root);
         cout << endl;
     }
-};
-
-
-int main() {
-    AVLTree tree;
     
     
-    tree.insert(10);
-    tree.insert(20);
-    tree.insert(30);
-    tree.insert(40);
-    tree.insert(50);
-    tree.insert(25);
+    // Call visit(key) for every key with lo <= key < hi, in order
+    template<typename F>
+    void range(int lo, int hi, F visit) {
+        rangeFrom(root, lo, hi, visit);
+    }
+    
     
+    int size() {
+        return size(root);
+    }
     
     
-    tree.printInOrder();
-    tree.printPreOrder();
+    // Number of keys below key
+    int rank(int key) {
+        int below = 0;
+        for (NodeType* node = root; node != nullptr;) {
+            if (key <= node->key) {
+                node = node->left;
+            } else {
+                below += size(node->left) + 1;
+                node = node->right;
+            }
+        }
+        return below;
+    }
     
     
-    tree.remove(30);
+    // The k-th smallest key counting from 0, or nullptr if k is out of range
+    const int* select(int k) {
+        NodeType* node = root;
+        while (node != nullptr) {
+            int leftSize = size(node->left);
+            if (k < leftSize) {
+                node = node->left;
+            } else if (k > leftSize) {
+                k -= leftSize + 1;
+                node = node->right;
+            } else {
+                return &node->key;
+            }
+        }
+        return nullptr;
+    }
     
     
-    tree.printInOrder();
-    tree.printPreOrder();
+    // Number of keys with lo <= key < hi
+    int countInRange(int lo, int hi) {
+        return lo < hi ? rank(hi) - rank(lo) : 0;
+    }
+    
+    
+    // Monoid sum of the keys with lo <= key < hi. Below the node where the
+    // searches for lo and hi part, whole subtrees hanging inside the range
+    // contribute their stored aggregate.
+    Aggregate sumInRange(int lo, int hi) {
+        NodeType* split = root;
+        while (split != nullptr && !(lo <= split->key && split->key < hi)) {
+            split = split->key < lo ? split->right : split->left;
+        }
+        if (split == nullptr) {
+            return Monoid::identity();
+        }
+        
+        
+        // Keys >= lo left of split, gathered from largest to smallest
+        Aggregate lower = Monoid::identity();
+        for (NodeType* node = split->left; node != nullptr;) {
+            if (lo <= node->key) {
+                lower = Monoid::combine(Monoid::combine(Monoid::lift(node->key), aggregate(node->right)), lower);
+                node = node->left;
+            } else {
+                node = node->right;
+            }
+        }
+        
+        // Keys < hi right of split, gathered from smallest to largest
+        Aggregate upper = Monoid::identity();
+        for (NodeType* node = split->right; node != nullptr;) {
+            if (node->key < hi) {
+                upper = Monoid::combine(upper, Monoid::combine(aggregate(node->left), Monoid::lift(node->key)));
+                node = node->right;
+            } else {
+                node = node->left;
+            }
+        }
+        
+        return Monoid::combine(Monoid::combine(lower, Monoid::lift(split->key)), upper);
+    }
+    
+    
+    // Set operations in place. other's nodes move into this tree and other
+    // is left empty. Large inputs are processed on TaskPool::shared().
+    void unionWith(AVLTree& other) {
+        combine(other, [this](NodeType* a, NodeType* b, vector<NodeType*>& d) { return unite(a, b, d); });
+    }
+    
+    void intersectWith(AVLTree& other) {
+        combine(other, [this](NodeType* a, NodeType* b, vector<NodeType*>& d) { return intersect(a, b, d); });
+    }
+    
+    void differenceWith(AVLTree& other) {
+        combine(other, [this](NodeType* a, NodeType* b, vector<NodeType*>& d) { return subtract(a, b, d); });
+    }
+    
+    
+    // Add ascending keys in O(n) by building a balanced tree over them and
+    // uniting it with the current contents. Repeated keys are skipped.
+    // Keys that are not in order fall back to one insert each, since the
+    // balanced build would silently break the search order.
+    void buildFromSorted(const vector<int>& keys) {
+        if (!is_sorted(keys.begin(), keys.end())) {
+            for (int key : keys) {
+                insert(key);
+            }
+            return;
+        }
+        
+        vector<NodeType*> nodes;
+        nodes.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (i == 0 || keys[i - 1] < keys[i]) {
+                nodes.push_back(pool.allocate(keys[i]));
+            }
+        }
+        
+        NodeType* built = build(nodes.data(), 0, static_cast<int>(nodes.size()));
+        vector<NodeType*> discarded;
+        root = unite(built, root, discarded);
+        for (NodeType* subtree : discarded) {
+            pool.releaseTree(subtree);
+        }
+    }
+};
+
+
+// Hazard slots for pinning the current version of a PersistentAVLTree.
+// A reader announces the root it is about to pin; the writer frees no
+// replaced root while some slot still holds it.
+class HazardDomain {
+public:
+    static const int MAX_THREADS = 256;
+    
+private:
+    struct alignas(64) Slot {
+        atomic<const void*> pointer;
+        atomic<bool> inUse;
+        
+        Slot() : pointer(nullptr), inUse(false) {}
+    };
+    
+    Slot slots[MAX_THREADS];
+    
+    
+    struct Registration {
+        Slot* slot = nullptr;
+        
+        ~Registration() {
+            if (slot != nullptr) {
+                slot->inUse.store(false, memory_order_release);
+            }
+        }
+    };
+    
+    HazardDomain() {}
+    
+public:
+    static HazardDomain& instance() {
+        static HazardDomain domain;
+        return domain;
+    }
+    
+    
+    atomic<const void*>& local() {
+        static thread_local Registration registration;
+        if (registration.slot == nullptr) {
+            for (int i = 0; ; i = (i + 1) % MAX_THREADS) {
+                bool expected = false;
+                if (!slots[i].inUse.load(memory_order_relaxed) &&
+                    slots[i].inUse.compare_exchange_strong(expected, true, memory_order_acquire)) {
+                    registration.slot = &slots[i];
+                    break;
+                }
+            }
+        }
+        return registration.slot->pointer;
+    }
+    
+    
+    bool isProtected(const void* pointer) {
+        for (int i = 0; i < MAX_THREADS; i++) {
+            if (slots[i].pointer.load(memory_order_seq_cst) == pointer) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+
+// Immutable node shared between versions. refs counts the parents and
+// pinned roots that point at it.
+class PNode {
+public:
+    int key;
+    const PNode* left;
+    const PNode* right;
+    int height;
+    int size;
+    mutable atomic<int> refs;
+    
+    PNode(int k, const PNode* l, const PNode* r)
+        : key(k), left(l), right(r),
+          height(max(l ? l->height : 0, r ? r->height : 0) + 1),
+          size((l ? l->size : 0) + (r ? r->size : 0) + 1), refs(1) {}
+};
+
+
+// Multi-version AVL tree. insert and remove copy the path to the changed
+// key and publish a new root; every other node is shared with the previous
+// version. Readers pin a version with snapshot() without taking a lock and
+// keep it consistent for as long as they hold it, while writers carry on.
+// A version's nodes are freed when its last snapshot and the tree drop it.
+class PersistentAVLTree {
+public:
+    class Snapshot {
+    private:
+        const PNode* root;
+        
+        template<typename F>
+        static void rangeFrom(const PNode* node, int lo, int hi, F& visit) {
+            if (node == nullptr) {
+                return;
+            }
+            
+            if (lo < node->key) {
+                rangeFrom(node->left, lo, hi, visit);
+            }
+            if (lo <= node->key && node->key < hi) {
+                visit(node->key);
+            }
+            if (node->key < hi) {
+                rangeFrom(node->right, lo, hi, visit);
+            }
+        }
+        
+    public:
+        // Takes over a reference already held on r
+        explicit Snapshot(const PNode* r = nullptr) : root(r) {}
+        
+        Snapshot(Snapshot&& other) : root(other.root) {
+            other.root = nullptr;
+        }
+        
+        Snapshot& operator=(Snapshot&& other) {
+            if (this != &other) {
+                release(root);
+                root = other.root;
+                other.root = nullptr;
+            }
+            return *this;
+        }
+        
+        ~Snapshot() {
+            release(root);
+        }
+        
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        
+        
+        bool search(int key) const {
+            const PNode* current = root;
+            while (current != nullptr && current->key != key) {
+                current = key < current->key ? current->left : current->right;
+            }
+            return current != nullptr;
+        }
+        
+        
+        int size() const {
+            return root == nullptr ? 0 : root->size;
+        }
+        
+        
+        // Call visit(key) for every key with lo <= key < hi, in order
+        template<typename F>
+        void range(int lo, int hi, F visit) const {
+            rangeFrom(root, lo, hi, visit);
+        }
+    };
+    
+private:
+    static const size_t SCAN_THRESHOLD = 32;
+    
+    // The tree holds one reference on the current root
+    atomic<const PNode*> current;
+    mutex writeLock;
+    vector<const PNode*> retired;
+    // retired.size(), readable without the lock
+    atomic<size_t> retiredCount;
+    
+    
+    static int height(const PNode* node) {
+        return node == nullptr ? 0 : node->height;
+    }
+    
+    static const PNode* share(const PNode* node) {
+        if (node != nullptr) {
+            node->refs.fetch_add(1, memory_order_relaxed);
+        }
+        return node;
+    }
+    
+    // Drop one reference, freeing every node that no version reaches any more
+    static void release(const PNode* node) {
+        vector<const PNode*> pending;
+        while (node != nullptr) {
+            if (node->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+                if (node->left != nullptr) {
+                    pending.push_back(node->left);
+                }
+                if (node->right != nullptr) {
+                    pending.push_back(node->right);
+                }
+                delete node;
+            }
+            
+            if (pending.empty()) {
+                return;
+            }
+            node = pending.back();
+            pending.pop_back();
+        }
+    }
+    
+    
+    // New node over left and right, whose references it takes over,
+    // rotating by copying when their heights differ by two
+    static const PNode* balance(int key, const PNode* left, const PNode* right) {
+        if (height(left) > height(right) + 1) {
+            int leftKey = left->key;
+            const PNode* outer = share(left->left);
+            const PNode* inner = left->right;
+            
+            if (height(outer) >= height(inner)) {
+                share(inner);
+                release(left);
+                return new PNode(leftKey, outer, new PNode(key, inner, right));
+            }
+            
+            int innerKey = inner->key;
+            const PNode* innerLeft = share(inner->left);
+            const PNode* innerRight = share(inner->right);
+            release(left);
+            return new PNode(innerKey, new PNode(leftKey, outer, innerLeft), new PNode(key, innerRight, right));
+        }
+        
+        
+        if (height(right) > height(left) + 1) {
+            int rightKey = right->key;
+            const PNode* outer = share(right->right);
+            const PNode* inner = right->left;
+            
+            if (height(outer) >= height(inner)) {
+                share(inner);
+                release(right);
+                return new PNode(rightKey, new PNode(key, left, inner), outer);
+            }
+            
+            int innerKey = inner->key;
+            const PNode* innerLeft = share(inner->left);
+            const PNode* innerRight = share(inner->right);
+            release(right);
+            return new PNode(innerKey, new PNode(key, left, innerLeft), new PNode(rightKey, innerRight, outer));
+        }
+        
+        return new PNode(key, left, right);
+    }
+    
+    
+    // The new subtree with key added, or nullptr if key is already there
+    static const PNode* insertInto(const PNode* node, int key, bool& changed) {
+        if (node == nullptr) {
+            changed = true;
+            return new PNode(key, nullptr, nullptr);
+        }
+        
+        if (key < node->key) {
+            const PNode* left = insertInto(node->left, key, changed);
+            return changed ? balance(node->key, left, share(node->right)) : nullptr;
+        }
+        if (key > node->key) {
+            const PNode* right = insertInto(node->right, key, changed);
+            return changed ? balance(node->key, share(node->left), right) : nullptr;
+        }
+        
+        changed = false;
+        return nullptr;
+    }
+    
+    
+    static const PNode* removeMin(const PNode* node, int& minKey) {
+        if (node->left == nullptr) {
+            minKey = node->key;
+            return share(node->right);
+        }
+        
+        const PNode* left = removeMin(node->left, minKey);
+        return balance(node->key, left, share(node->right));
+    }
+    
+    
+    // The new subtree without key; only meaningful if changed is set
+    static const PNode* removeFrom(const PNode* node, int key, bool& changed) {
+        if (node == nullptr) {
+            changed = false;
+            return nullptr;
+        }
+        
+        if (key < node->key) {
+            const PNode* left = removeFrom(node->left, key, changed);
+            return changed ? balance(node->key, left, share(node->right)) : nullptr;
+        }
+        if (key > node->key) {
+            const PNode* right = removeFrom(node->right, key, changed);
+            return changed ? balance(node->key, share(node->left), right) : nullptr;
+        }
+        
+        
+        changed = true;
+        if (node->left == nullptr) {
+            return share(node->right);
+        }
+        if (node->right == nullptr) {
+            return share(node->left);
+        }
+        
+        int successor;
+        const PNode* right = removeMin(node->right, successor);
+        return balance(successor, share(node->left), right);
+    }
+    
+    
+    // Release every retired root that no reader is in the middle of
+    // pinning; caller holds writeLock
+    void scanRetired() {
+        HazardDomain& hazards = HazardDomain::instance();
+        size_t kept = 0;
+        for (const PNode* version : retired) {
+            if (hazards.isProtected(version)) {
+                retired[kept++] = version;
+            } else {
+                release(version);
+            }
+        }
+        retired.resize(kept);
+        retiredCount.store(kept, memory_order_relaxed);
+    }
+    
+    
+    // Swap in the new root and retire the old one. Replaced roots are
+    // released in batches by writers, and by readers once writes stop.
+    Snapshot publish(const PNode* root) {
+        Snapshot pinned(share(root));
+        const PNode* old = current.exchange(root, memory_order_seq_cst);
+        if (old != nullptr) {
+            retired.push_back(old);
+            retiredCount.store(retired.size(), memory_order_relaxed);
+        }
+        
+        if (retired.size() >= SCAN_THRESHOLD) {
+            scanRetired();
+        }
+        return pinned;
+    }
+    
+public:
+    PersistentAVLTree() : current(nullptr), retiredCount(0) {}
+    
+    // Readers must be done pinning; snapshots already taken stay valid
+    ~PersistentAVLTree() {
+        release(current.load(memory_order_relaxed));
+        for (const PNode* version : retired) {
+            release(version);
+        }
+    }
+    
+    PersistentAVLTree(const PersistentAVLTree&) = delete;
+    PersistentAVLTree& operator=(const PersistentAVLTree&) = delete;
+    
+    
+    // Pin the current version. The root is announced in a hazard slot and
+    // re-read, so the writer cannot free it before the reference is taken.
+    Snapshot snapshot() {
+        atomic<const void*>& hazard = HazardDomain::instance().local();
+        const PNode* root;
+        do {
+            root = current.load(memory_order_seq_cst);
+            hazard.store(root, memory_order_seq_cst);
+        } while (root != current.load(memory_order_seq_cst));
+        
+        share(root);
+        hazard.store(nullptr, memory_order_release);
+        
+        // A writer that went idle after a burst leaves old versions behind;
+        // the reader frees them, unless a writer is busy and will anyway
+        if (retiredCount.load(memory_order_relaxed) > 0) {
+            unique_lock<mutex> guard(writeLock, try_to_lock);
+            if (guard.owns_lock()) {
+                scanRetired();
+            }
+        }
+        return Snapshot(root);
+    }
+    
+    
+    // Free every replaced version that no snapshot holds and no reader is
+    // pinning, without waiting for the next write
+    void reclaim() {
+        lock_guard<mutex> guard(writeLock);
+        scanRetired();
+    }
+    
+    
+    // Replaced versions the tree still holds a reference on
+    size_t retiredVersions() {
+        return retiredCount.load(memory_order_relaxed);
+    }
+    
+    
+    // Each returns the version it leaves current
+    Snapshot insert(int key) {
+        lock_guard<mutex> guard(writeLock);
+        bool changed = false;
+        const PNode* root = insertInto(current.load(memory_order_relaxed), key, changed);
+        return changed ? publish(root) : Snapshot(share(current.load(memory_order_relaxed)));
+    }
+    
+    Snapshot remove(int key) {
+        lock_guard<mutex> guard(writeLock);
+        bool changed = false;
+        const PNode* root = removeFrom(current.load(memory_order_relaxed), key, changed);
+        return changed ? publish(root) : Snapshot(share(current.load(memory_order_relaxed)));
+    }
+    
+    
+    bool search(int key) {
+        return snapshot().search(key);
+    }
+};
+
+
+// B+-tree over int keys with the same surface as AVLTree. Nodes hold many
+// keys in a few cache lines, so a lookup touches one node per level instead
+// of one per key comparison, and leaves are chained for range scans.
+// Unused key slots hold INT_MAX so the in-node search can scan the whole
+// fixed-size array without a bound, which the compiler vectorizes.
+class BPlusTree {
+private:
+    static const int LEAF_KEYS = 32;
+    static const int INNER_KEYS = 32;
+    static const int MIN_LEAF = LEAF_KEYS / 2;
+    static const int MIN_INNER = INNER_KEYS / 2;
+    
+    
+    struct alignas(64) Leaf {
+        int keys[LEAF_KEYS];
+        int count;
+        Leaf* next;
+        
+        Leaf() : count(0), next(nullptr) {
+            fill(keys, keys + LEAF_KEYS, INT_MAX);
+        }
+    };
+    
+    struct alignas(64) Inner {
+        int keys[INNER_KEYS];
+        int count;
+        void* children[INNER_KEYS + 1];
+        
+        Inner() : count(0) {
+            fill(keys, keys + INNER_KEYS, INT_MAX);
+        }
+    };
+    
+    
+    // Levels of inner nodes above the leaves; 0 means the root is a leaf
+    int depth;
+    void* root;
+    
+    
+    // Number of keys below key, i.e. its position within a leaf
+    static int lowerIndex(const int* keys, int n, int key) {
+        int below = 0;
+        for (int i = 0; i < n; i++) {
+            below += keys[i] < key;
+        }
+        return below;
+    }
+    
+    // Child to descend into: separators are the smallest key of the child
+    // to their right
+    static int childIndex(const Inner* node, int key) {
+        int notAbove = 0;
+        for (int i = 0; i < INNER_KEYS; i++) {
+            notAbove += node->keys[i] <= key;
+        }
+        return min(notAbove, node->count);
+    }
+    
+    
+    Leaf* findLeaf(int key) {
+        void* node = root;
+        for (int d = depth; d > 0; d--) {
+            Inner* inner = static_cast<Inner*>(node);
+            node = inner->children[childIndex(inner, key)];
+        }
+        return static_cast<Leaf*>(node);
+    }
+    
+    
+    static void insertAt(int* keys, int count, int pos, int key) {
+        copy_backward(keys + pos, keys + count, keys + count + 1);
+        keys[pos] = key;
+    }
+    
+    static void eraseAt(int* keys, int count, int pos) {
+        copy(keys + pos + 1, keys + count, keys + pos);
+        keys[count - 1] = INT_MAX;
+    }
+    
+    
+    // Insert into the subtree; if node splits, the new right sibling and its
+    // smallest key are returned through split and separator
+    bool insertInto(void* node, int d, int key, void*& split, int& separator) {
+        if (d == 0) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int pos = lowerIndex(leaf->keys, LEAF_KEYS, key);
+            if (pos < leaf->count && leaf->keys[pos] == key) {
+                return false;
+            }
+            
+            if (leaf->count == LEAF_KEYS) {
+                Leaf* right = new Leaf();
+                right->count = LEAF_KEYS - MIN_LEAF;
+                copy(leaf->keys + MIN_LEAF, leaf->keys + LEAF_KEYS, right->keys);
+                fill(leaf->keys + MIN_LEAF, leaf->keys + LEAF_KEYS, INT_MAX);
+                leaf->count = MIN_LEAF;
+                right->next = leaf->next;
+                leaf->next = right;
+                
+                if (pos > MIN_LEAF) {
+                    leaf = right;
+                    pos -= MIN_LEAF;
+                }
+                split = right;
+            }
+            
+            insertAt(leaf->keys, leaf->count, pos, key);
+            leaf->count++;
+            if (split != nullptr) {
+                separator = static_cast<Leaf*>(split)->keys[0];
+            }
+            return true;
+        }
+        
+        
+        Inner* inner = static_cast<Inner*>(node);
+        int idx = childIndex(inner, key);
+        void* childSplit = nullptr;
+        int childSeparator = 0;
+        if (!insertInto(inner->children[idx], d - 1, key, childSplit, childSeparator)) {
+            return false;
+        }
+        if (childSplit == nullptr) {
+            return true;
+        }
+        
+        
+        if (inner->count == INNER_KEYS) {
+            // Push the middle separator up; it belongs to neither half
+            Inner* right = new Inner();
+            right->count = INNER_KEYS - MIN_INNER - 1;
+            copy(inner->keys + MIN_INNER + 1, inner->keys + INNER_KEYS, right->keys);
+            copy(inner->children + MIN_INNER + 1, inner->children + INNER_KEYS + 1, right->children);
+            separator = inner->keys[MIN_INNER];
+            fill(inner->keys + MIN_INNER, inner->keys + INNER_KEYS, INT_MAX);
+            inner->count = MIN_INNER;
+            split = right;
+            
+            if (idx > MIN_INNER) {
+                inner = right;
+                idx -= MIN_INNER + 1;
+            }
+        }
+        
+        insertAt(inner->keys, inner->count, idx, childSeparator);
+        copy_backward(inner->children + idx + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+        inner->children[idx + 1] = childSplit;
+        inner->count++;
+        return true;
+    }
+    
+    
+    static int keyCount(void* node, int d) {
+        return d == 0 ? static_cast<Leaf*>(node)->count : static_cast<Inner*>(node)->count;
+    }
+    
+    
+    // Refill parent->children[idx] after it dropped below half full, by
+    // borrowing from a sibling that can spare a key or merging with one
+    void rebalance(Inner* parent, int idx, int d) {
+        int minKeys = d == 0 ? MIN_LEAF : MIN_INNER;
+        
+        
+        if (idx + 1 <= parent->count && keyCount(parent->children[idx + 1], d) > minKeys) {
+            if (d == 0) {
+                Leaf* child = static_cast<Leaf*>(parent->children[idx]);
+                Leaf* sibling = static_cast<Leaf*>(parent->children[idx + 1]);
+                child->keys[child->count++] = sibling->keys[0];
+                eraseAt(sibling->keys, sibling->count--, 0);
+                parent->keys[idx] = sibling->keys[0];
+            } else {
+                Inner* child = static_cast<Inner*>(parent->children[idx]);
+                Inner* sibling = static_cast<Inner*>(parent->children[idx + 1]);
+                child->keys[child->count] = parent->keys[idx];
+                child->children[child->count + 1] = sibling->children[0];
+                child->count++;
+                parent->keys[idx] = sibling->keys[0];
+                eraseAt(sibling->keys, sibling->count, 0);
+                copy(sibling->children + 1, sibling->children + sibling->count + 1, sibling->children);
+                sibling->count--;
+            }
+            return;
+        }
+        
+        
+        if (idx > 0 && keyCount(parent->children[idx - 1], d) > minKeys) {
+            if (d == 0) {
+                Leaf* child = static_cast<Leaf*>(parent->children[idx]);
+                Leaf* sibling = static_cast<Leaf*>(parent->children[idx - 1]);
+                insertAt(child->keys, child->count++, 0, sibling->keys[sibling->count - 1]);
+                sibling->keys[--sibling->count] = INT_MAX;
+                parent->keys[idx - 1] = child->keys[0];
+            } else {
+                Inner* child = static_cast<Inner*>(parent->children[idx]);
+                Inner* sibling = static_cast<Inner*>(parent->children[idx - 1]);
+                insertAt(child->keys, child->count, 0, parent->keys[idx - 1]);
+                copy_backward(child->children, child->children + child->count + 1, child->children + child->count + 2);
+                child->children[0] = sibling->children[sibling->count];
+                child->count++;
+                parent->keys[idx - 1] = sibling->keys[sibling->count - 1];
+                sibling->keys[--sibling->count] = INT_MAX;
+            }
+            return;
+        }
+        
+        
+        // Neither sibling can lend, so merge the pair into the left node
+        int left = idx > 0 ? idx - 1 : idx;
+        if (d == 0) {
+            Leaf* into = static_cast<Leaf*>(parent->children[left]);
+            Leaf* from = static_cast<Leaf*>(parent->children[left + 1]);
+            copy(from->keys, from->keys + from->count, into->keys + into->count);
+            into->count += from->count;
+            into->next = from->next;
+            delete from;
+        } else {
+            Inner* into = static_cast<Inner*>(parent->children[left]);
+            Inner* from = static_cast<Inner*>(parent->children[left + 1]);
+            into->keys[into->count] = parent->keys[left];
+            copy(from->keys, from->keys + from->count, into->keys + into->count + 1);
+            copy(from->children, from->children + from->count + 1, into->children + into->count + 1);
+            into->count += from->count + 1;
+            delete from;
+        }
+        
+        eraseAt(parent->keys, parent->count, left);
+        copy(parent->children + left + 2, parent->children + parent->count + 1, parent->children + left + 1);
+        parent->count--;
+    }
+    
+    
+    bool removeFrom(void* node, int d, int key) {
+        if (d == 0) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            int pos = lowerIndex(leaf->keys, LEAF_KEYS, key);
+            if (pos == leaf->count || leaf->keys[pos] != key) {
+                return false;
+            }
+            eraseAt(leaf->keys, leaf->count--, pos);
+            return true;
+        }
+        
+        
+        Inner* inner = static_cast<Inner*>(node);
+        int idx = childIndex(inner, key);
+        if (!removeFrom(inner->children[idx], d - 1, key)) {
+            return false;
+        }
+        
+        if (keyCount(inner->children[idx], d - 1) < (d == 1 ? MIN_LEAF : MIN_INNER)) {
+            rebalance(inner, idx, d - 1);
+        }
+        return true;
+    }
+    
+    
+    void destroy(void* node, int d) {
+        if (d > 0) {
+            Inner* inner = static_cast<Inner*>(node);
+            for (int i = 0; i <= inner->count; i++) {
+                destroy(inner->children[i], d - 1);
+            }
+            delete inner;
+        } else {
+            delete static_cast<Leaf*>(node);
+        }
+    }
+    
+public:
+    BPlusTree() : depth(0), root(new Leaf()) {}
+    
+    ~BPlusTree() {
+        destroy(root, depth);
+    }
+    
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+    
+    
+    bool search(int key) {
+        Leaf* leaf = findLeaf(key);
+        int pos = lowerIndex(leaf->keys, LEAF_KEYS, key);
+        return pos < leaf->count && leaf->keys[pos] == key;
+    }
+    
+    
+    void insert(int key) {
+        void* split = nullptr;
+        int separator = 0;
+        insertInto(root, depth, key, split, separator);
+        
+        if (split != nullptr) {
+            Inner* newRoot = new Inner();
+            newRoot->keys[0] = separator;
+            newRoot->children[0] = root;
+            newRoot->children[1] = split;
+            newRoot->count = 1;
+            root = newRoot;
+            depth++;
+        }
+    }
+    
+    
+    void remove(int key) {
+        removeFrom(root, depth, key);
+        
+        if (depth > 0 && static_cast<Inner*>(root)->count == 0) {
+            Inner* oldRoot = static_cast<Inner*>(root);
+            root = oldRoot->children[0];
+            depth--;
+            delete oldRoot;
+        }
+    }
+    
+    
+    // Call visit(key) for every key with lo <= key < hi, in order
+    template<typename F>
+    void range(int lo, int hi, F visit) {
+        Leaf* leaf = findLeaf(lo);
+        int pos = lowerIndex(leaf->keys, LEAF_KEYS, lo);
+        for (; leaf != nullptr; leaf = leaf->next, pos = 0) {
+            if (leaf->next != nullptr) {
+                __builtin_prefetch(leaf->next);
+            }
+            for (; pos < leaf->count; pos++) {
+                if (leaf->keys[pos] >= hi) {
+                    return;
+                }
+                visit(leaf->keys[pos]);
+            }
+        }
+    }
+    
+    
+    void printInOrder() {
+        cout << "In-order traversal: ";
+        range(INT_MIN, INT_MAX, [](int key) { cout << key << " "; });
+        cout << endl;
+    }
+};
+
+
+template<typename Tree>
+double timeInserts(Tree& tree, const vector<int>& keys) {
+    auto start = chrono::steady_clock::now();
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+
+template<typename Tree>
+double timeLookups(Tree& tree, const vector<int>& probes, long long& hits) {
+    auto start = chrono::steady_clock::now();
+    for (int key : probes) {
+        hits += tree.search(key);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / probes.size();
+}
+
+
+template<typename Tree>
+double timeScans(Tree& tree, const vector<int>& starts, int width, long long& sum) {
+    auto start = chrono::steady_clock::now();
+    for (int lo : starts) {
+        tree.range(lo, lo + width, [&sum](int key) { sum += key; });
+    }
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / starts.size();
+}
+
+
+// Random inserts, point lookups (half hits) and range scans of about 1000
+// keys on n keys spaced two apart
+void benchmarkTrees(int n) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 2;
+    }
+    mt19937 rng(5);
+    shuffle(keys.begin(), keys.end(), rng);
+    
+    vector<int> probes(1000000);
+    for (int& key : probes) {
+        key = static_cast<int>(rng() % (2ull * n));
+    }
+    vector<int> starts(2000);
+    for (int& lo : starts) {
+        lo = static_cast<int>(rng() % (2ull * n));
+    }
+    
+    long long avlHits = 0, btreeHits = 0, avlSum = 0, btreeSum = 0;
+    double avlInsert, btreeInsert, avlLookup, btreeLookup, avlScan, btreeScan;
+    {
+        AVLTree<> avl;
+        avlInsert = timeInserts(avl, keys);
+        avlLookup = timeLookups(avl, probes, avlHits);
+        avlScan = timeScans(avl, starts, 2000, avlSum);
+    }
+    {
+        BPlusTree btree;
+        btreeInsert = timeInserts(btree, keys);
+        btreeLookup = timeLookups(btree, probes, btreeHits);
+        btreeScan = timeScans(btree, starts, 2000, btreeSum);
+    }
+    
+    cout << n << " keys: insert AVL " << avlInsert << " s, B+ " << btreeInsert << " s; lookup AVL "
+         << avlLookup << " ns, B+ " << btreeLookup << " ns; scan AVL " << avlScan << " us, B+ "
+         << btreeScan << " us" << (avlHits == btreeHits && avlSum == btreeSum ? "" : " (mismatch)") << endl;
+}
+
+
+// Count and sum over windows of about 1000 keys, answered from the subtree
+// sizes and aggregates versus visiting every key in the window
+void benchmarkRangeAggregates(int n, int queries) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 2;
+    }
+    mt19937 rng(8);
+    shuffle(keys.begin(), keys.end(), rng);
+    
+    AVLTree<> tree;
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    
+    vector<int> starts(queries);
+    for (int& lo : starts) {
+        lo = static_cast<int>(rng() % (2ull * n));
+    }
+    
+    long long augmented = 0, scanned = 0;
+    auto start = chrono::steady_clock::now();
+    for (int lo : starts) {
+        augmented += tree.countInRange(lo, lo + 2000) + tree.sumInRange(lo, lo + 2000);
+    }
+    auto middle = chrono::steady_clock::now();
+    for (int lo : starts) {
+        tree.range(lo, lo + 2000, [&scanned](int key) { scanned += 1 + key; });
+    }
+    auto end = chrono::steady_clock::now();
+    
+    cout << n << " keys: countInRange + sumInRange "
+         << chrono::duration<double, nano>(middle - start).count() / queries << " ns/query, scan "
+         << chrono::duration<double, nano>(end - middle).count() / queries << " ns/query"
+         << (augmented == scanned ? "" : " (mismatch)") << endl;
+}
+
+
+// Two sets of n keys sharing half of their keys: bulk build and the set
+// operations, against building and merging one insert at a time
+void benchmarkSetOperations(int n) {
+    vector<int> first(n), second(n);
+    for (int i = 0; i < n; i++) {
+        first[i] = i * 2;
+        second[i] = i * 2 + (i % 2 == 0 ? 0 : n);
+    }
+    sort(second.begin(), second.end());
+    
+    auto seconds = [](chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+        return chrono::duration<double>(b - a).count();
+    };
+    
+    auto t0 = chrono::steady_clock::now();
+    AVLTree<> byInsert;
+    for (int key : first) {
+        byInsert.insert(key);
+    }
+    auto t1 = chrono::steady_clock::now();
+    for (int key : second) {
+        byInsert.insert(key);
+    }
+    auto t2 = chrono::steady_clock::now();
+    
+    AVLTree<> a, b;
+    a.buildFromSorted(first);
+    auto t3 = chrono::steady_clock::now();
+    b.buildFromSorted(second);
+    auto t4 = chrono::steady_clock::now();
+    a.unionWith(b);
+    auto t5 = chrono::steady_clock::now();
+    
+    AVLTree<> c, d;
+    c.buildFromSorted(first);
+    d.buildFromSorted(second);
+    auto t6 = chrono::steady_clock::now();
+    c.intersectWith(d);
+    auto t7 = chrono::steady_clock::now();
+    
+    AVLTree<> e, f;
+    e.buildFromSorted(first);
+    f.buildFromSorted(second);
+    auto t8 = chrono::steady_clock::now();
+    e.differenceWith(f);
+    auto t9 = chrono::steady_clock::now();
+    
+    // Unsorted input must give the same set as sorted input
+    vector<int> shuffled = first;
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(n));
+    AVLTree<> g;
+    g.buildFromSorted(shuffled);
+    
+    bool consistent = a.size() == byInsert.size() && c.size() + e.size() == n && g.size() == n &&
+                      g.rank(first[n / 2]) == n / 2;
+    cout << n << " keys, " << TaskPool::shared().threads() << " threads: build by insert " << seconds(t0, t1)
+         << " s, buildFromSorted " << seconds(t3, t4) << " s; merge by insert " << seconds(t1, t2)
+         << " s, unionWith " << seconds(t4, t5) << " s, intersectWith " << seconds(t6, t7)
+         << " s, differenceWith " << seconds(t8, t9) << " s" << (consistent ? "" : " (mismatch)") << endl;
+}
+
+
+// Writes completed on n keys in one second while two threads keep scanning
+// the whole set: PersistentAVLTree readers scan a snapshot, AVLTree readers
+// hold a shared lock that the writer has to wait out
+void benchmarkSnapshotWrites(int n) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 2;
+    }
+    mt19937 rng(13);
+    shuffle(keys.begin(), keys.end(), rng);
+    
+    auto run = [&](auto scan, auto write) {
+        auto deadline = chrono::steady_clock::now() + chrono::seconds(1);
+        atomic<long long> scans(0);
+        vector<thread> readers;
+        for (int t = 0; t < 2; t++) {
+            readers.emplace_back([&]() {
+                while (chrono::steady_clock::now() < deadline) {
+                    scan();
+                    scans++;
+                }
+            });
+        }
+        
+        long long writes = 0;
+        for (mt19937 ops(17); chrono::steady_clock::now() < deadline; writes++) {
+            write(static_cast<int>(ops() % (2ull * n)), writes % 2 == 0);
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        return make_pair(writes, scans.load());
+    };
+    
+    
+    PersistentAVLTree persistent;
+    for (int key : keys) {
+        persistent.insert(key);
+    }
+    auto versioned = run(
+        [&]() {
+            long long sum = 0;
+            persistent.snapshot().range(INT_MIN, INT_MAX, [&sum](int key) { sum += key; });
+            return sum;
+        },
+        [&](int key, bool add) {
+            if (add) {
+                persistent.insert(key);
+            } else {
+                persistent.remove(key);
+            }
+        });
+    
+    AVLTree<> tree;
+    shared_mutex treeLock;
+    for (int key : keys) {
+        tree.insert(key);
+    }
+    auto locked = run(
+        [&]() {
+            shared_lock<shared_mutex> guard(treeLock);
+            long long sum = 0;
+            tree.range(INT_MIN, INT_MAX, [&sum](int key) { sum += key; });
+            return sum;
+        },
+        [&](int key, bool add) {
+            unique_lock<shared_mutex> guard(treeLock);
+            if (add) {
+                tree.insert(key);
+            } else {
+                tree.remove(key);
+            }
+        });
+    
+    cout << n << " keys, 2 scanning readers, 1 s: snapshots " << versioned.first << " writes (" << versioned.second
+         << " scans), shared_mutex " << locked.first << " writes (" << locked.second << " scans)" << endl;
+}
+
+
+void runBenchmarks(const vector<int>& sizes) {
+    for (int n : sizes) {
+        benchmarkTrees(n);
+    }
+    for (int n : sizes) {
+        benchmarkRangeAggregates(n, 20000);
+    }
+    for (int n : sizes) {
+        benchmarkSetOperations(n);
+    }
+    benchmarkSnapshotWrites(100000);
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        vector<int> sizes;
+        for (int i = 2; i < argc; i++) {
+            sizes.push_back(atoi(argv[i]));
+        }
+        if (sizes.empty()) {
+            sizes = {1000000, 10000000};
+        }
+        runBenchmarks(sizes);
+        return 0;
+    }
+    
+    AVLTree<> tree;
+    
+    
+    tree.insert(10);
+    tree.insert(20);
+    tree.insert(30);
+    tree.insert(40);
+    tree.insert(50);
+    tree.insert(25);
+    
+    
+    
+    tree.printInOrder();
+    tree.printPreOrder();
+    
+    
+    tree.remove(30);
+    
+    
+    tree.printInOrder();
+    tree.printPreOrder();
+    
+    cout << "Rank of 40: " << tree.rank(40) << ", key at 2: " << *tree.select(2) << endl;
+    cout << "Count in [15, 45): " << tree.countInRange(15, 45)
+         << ", sum in [15, 45): " << tree.sumInRange(15, 45) << endl;
+    
+    
+    AVLTree<> unsorted;
+    unsorted.buildFromSorted({30, 10, 20, 10, 5});
+    unsorted.printInOrder();
+    cout << "Rank of 20: " << unsorted.rank(20) << ", search 5: " << (unsorted.search(5) ? "Found" : "Not Found") << endl;
+    
+    
+    BPlusTree btree;
+    for (int key = 1; key <= 100; key++) {
+        btree.insert(key * 10);
+    }
+    for (int key = 1; key <= 100; key += 2) {
+        btree.remove(key * 10);
+    }
+    cout << "B+-tree search 40: " << (btree.search(40) ? "Found" : "Not Found")
+         << ", search 50: " << (btree.search(50) ? "Found" : "Not Found") << endl;
+    cout << "B+-tree keys in [100, 200):";
+    btree.range(100, 200, [](int key) { cout << " " << key; });
+    cout << endl;
+    
+    
+    PersistentAVLTree versions;
+    for (int key : {10, 20, 30, 40}) {
+        versions.insert(key);
+    }
+    PersistentAVLTree::Snapshot before = versions.snapshot();
+    versions.remove(20);
+    versions.insert(25);
+    cout << "Replaced versions held after the writes: " << versions.retiredVersions();
+    versions.search(25);
+    cout << ", after a read: " << versions.retiredVersions() << endl;
+    cout << "Snapshot:";
+    before.range(INT_MIN, INT_MAX, [](int key) { cout << " " << key; });
+    cout << ", current:";
+    versions.snapshot().range(INT_MIN, INT_MAX, [](int key) { cout << " " << key; });
+    cout << endl;
     
     return 0;
 }
\ No newline at end of file
@@ -1,165 +1,985 @@
 #include <iostream>
 #include <climits>
+#include <vector>
+#include <queue>
+#include <random>
+#include <chrono>
+#include <string>
+#include <functional>
+#include <cstdint>
 using namespace std;
 
+// Heaps address their nodes and items by 32-bit index into their own slabs.
+// Slot 0 of each slab is reserved so that 0 can stand for a null link.
+typedef uint32_t Index;
+const Index NIL = 0;
+
+// One entry. Keys move between nodes while bubbling up, so the item travels
+// with its key and always records the node holding it.
+struct Item {
+    Index node;
+    int value;
+};
+
 struct Node {
     int key, degree;
-    Node *parent, *child, *sibling;
-
-    Node(int val) {
-        key = val;
-        degree = 0;
-        parent = child = sibling = nullptr;
-    }
+    Index parent, child, sibling;
+    Index item;
 };
 
+// Degrees never exceed log2 of the node count
+const int MAX_DEGREE = 64;
+
 class BinomialHeap {
-    Node* head;
-
-    Node* mergeTrees(Node* b1, Node* b2) {
-        if (b1->key > b2->key) swap(b1, b2);
-        b2->parent = b1;
-        b2->sibling = b1->child;
-        b1->child = b2;
-        b1->degree++;
+    // Slabs of nodes and items plus the slots freed by extractMin and erase,
+    // reused before the slabs grow. Growing moves elements but keeps their
+    // indices, and nothing in them needs destroying, so clearing or dropping
+    // a heap of any size is a couple of deallocations.
+    vector<Node> nodes;
+    vector<Item> items;
+    vector<Index> freeNodes, freeItems;
+    Index head;
+    // Root with the smallest key, kept up to date so findMin is O(1)
+    Index minNode;
+    // Lazy heaps just add each insert to the root list as a B0 tree and
+    // leave all linking to the next extractMin
+    bool lazy;
+
+    Index newNode(int key, Index item) {
+        Index i;
+        if (freeNodes.empty()) {
+            i = static_cast<Index>(nodes.size());
+            nodes.push_back(Node());
+        } else {
+            i = freeNodes.back();
+            freeNodes.pop_back();
+        }
+        nodes[i] = Node{key, 0, NIL, NIL, NIL, item};
+        return i;
+    }
+
+    Index newItem(int value) {
+        Index i;
+        if (freeItems.empty()) {
+            i = static_cast<Index>(items.size());
+            items.push_back(Item());
+        } else {
+            i = freeItems.back();
+            freeItems.pop_back();
+        }
+        items[i] = Item{NIL, value};
+        return i;
+    }
+
+    Index mergeTrees(Index b1, Index b2) {
+        if (nodes[b1].key > nodes[b2].key) swap(b1, b2);
+        // On a tie the cached minimum may be the root that goes under
+        if (b2 == minNode) minNode = b1;
+        Node& top = nodes[b1];
+        Node& sub = nodes[b2];
+        sub.parent = b1;
+        sub.sibling = top.child;
+        top.child = b2;
+        top.degree++;
         return b1;
     }
 
-    Node* unionHeaps(Node* h1, Node* h2) {
+    Index unionHeaps(Index h1, Index h2) {
         if (!h1) return h2;
         if (!h2) return h1;
 
-        Node* res;
-        Node* tail;
+        Index res;
+        Index tail;
 
-        if (h1->degree <= h2->degree) {
+        if (nodes[h1].degree <= nodes[h2].degree) {
             res = h1;
-            h1 = h1->sibling;
+            h1 = nodes[h1].sibling;
         } else {
             res = h2;
-            h2 = h2->sibling;
+            h2 = nodes[h2].sibling;
         }
 
         tail = res;
 
         while (h1 && h2) {
-            if (h1->degree <= h2->degree) {
-                tail->sibling = h1;
-                h1 = h1->sibling;
+            if (nodes[h1].degree <= nodes[h2].degree) {
+                nodes[tail].sibling = h1;
+                h1 = nodes[h1].sibling;
             } else {
-                tail->sibling = h2;
-                h2 = h2->sibling;
+                nodes[tail].sibling = h2;
+                h2 = nodes[h2].sibling;
             }
-            tail = tail->sibling;
+            tail = nodes[tail].sibling;
         }
 
-        tail->sibling = h1 ? h1 : h2;
+        nodes[tail].sibling = h1 ? h1 : h2;
         return res;
     }
 
-    void linkTrees(Node* &head) {
+    void linkTrees(Index &head) {
         if (!head) return;
 
-        Node* prev = nullptr;
-        Node* curr = head;
-        Node* next = curr->sibling;
+        Index prev = NIL;
+        Index curr = head;
+        Index next = nodes[curr].sibling;
 
         while (next) {
-            if ((curr->degree != next->degree) ||
-                (next->sibling && next->sibling->degree == curr->degree)) {
+            Index after = nodes[next].sibling;
+            if ((nodes[curr].degree != nodes[next].degree) ||
+                (after && nodes[after].degree == nodes[curr].degree)) {
                 prev = curr;
                 curr = next;
             } else {
-                if (curr->key <= next->key) {
-                    curr->sibling = next->sibling;
+                if (nodes[curr].key <= nodes[next].key) {
+                    nodes[curr].sibling = after;
                     curr = mergeTrees(curr, next);
                 } else {
-                    if (prev == nullptr) head = next;
-                    else prev->sibling = next;
+                    if (prev == NIL) head = next;
+                    else nodes[prev].sibling = next;
                     curr = mergeTrees(next, curr);
                 }
             }
-            next = curr->sibling;
+            next = nodes[curr].sibling;
         }
     }
 
-    Node* reverseList(Node* node) {
-        Node* prev = nullptr;
-        while (node) {
-            Node* next = node->sibling;
-            node->sibling = prev;
-            node->parent = nullptr;
-            prev = node;
-            node = next;
+    void addToDegrees(Index* byDegree, int& maxDegree, Index tree) {
+        nodes[tree].parent = NIL;
+        while (byDegree[nodes[tree].degree]) {
+            Index other = byDegree[nodes[tree].degree];
+            byDegree[nodes[tree].degree] = NIL;
+            tree = mergeTrees(tree, other);
         }
-        return prev;
+        byDegree[nodes[tree].degree] = tree;
+        maxDegree = max(maxDegree, nodes[tree].degree);
     }
 
-public:
-    BinomialHeap(): head(nullptr) {}
-
-    void insert(int key) {
-        Node* temp = new Node(key);
-        head = unionHeaps(head, temp);
-        linkTrees(head);
-    }
-
-    Node* findMin() {
-        Node* y = nullptr;
-        Node* x = head;
-        int minVal = INT_MAX;
-        while (x != nullptr) {
-            if (x->key < minVal) {
-                minVal = x->key;
-                y = x;
+    // Link the trees of both lists, leaving out skip, in one pass over a
+    // degree-indexed array: a tree whose degree is taken is linked with the
+    // tree there and carried one slot up. The slots then give the new root
+    // list in increasing degree order, and its minimum.
+    void consolidate(Index list1, Index list2, Index skip) {
+        Index byDegree[MAX_DEGREE + 1] = {};
+        int maxDegree = 0;
+        for (Index list : {list1, list2}) {
+            while (list) {
+                Index next = nodes[list].sibling;
+                if (list != skip) addToDegrees(byDegree, maxDegree, list);
+                list = next;
             }
-            x = x->sibling;
         }
-        return y;
+
+        head = minNode = NIL;
+        Index tail = NIL;
+        for (int d = 0; d <= maxDegree; d++) {
+            Index tree = byDegree[d];
+            if (!tree) continue;
+            nodes[tree].sibling = NIL;
+            if (tail) nodes[tail].sibling = tree;
+            else head = tree;
+            tail = tree;
+            if (!minNode || nodes[tree].key < nodes[minNode].key) minNode = tree;
+        }
     }
 
-    int extractMin() {
-        if (!head) return INT_MAX;
+    void swapEntries(Index a, Index b) {
+        swap(nodes[a].key, nodes[b].key);
+        swap(nodes[a].item, nodes[b].item);
+        items[nodes[a].item].node = a;
+        items[nodes[b].item].node = b;
+    }
+
+    // Move node's entry up while it beats its parent, or all the way to the
+    // root when toRoot is set; returns the node it ends in
+    Index bubbleUp(Index node, bool toRoot) {
+        while (nodes[node].parent && (toRoot || nodes[node].key < nodes[nodes[node].parent].key)) {
+            swapEntries(node, nodes[node].parent);
+            node = nodes[node].parent;
+        }
+        if (!nodes[node].parent && nodes[node].key < nodes[minNode].key) minNode = node;
+        return node;
+    }
+
+    // Drop a root and rebuild the root list from the other roots and its
+    // children in a single consolidation pass; returns its key
+    int removeRoot(Index root) {
+        consolidate(head, nodes[root].child, root);
+
+        freeItems.push_back(nodes[root].item);
+        freeNodes.push_back(root);
+        return nodes[root].key;
+    }
+
+    // Append other's slabs to ours, shifting its links past our slots so its
+    // node i becomes node i + shift and its item i becomes i + itemShift;
+    // returns the node shift
+    Index adopt(BinomialHeap& other, Index& itemShift) {
+        Index shift = static_cast<Index>(nodes.size()) - 1;
+        itemShift = static_cast<Index>(items.size()) - 1;
+        for (size_t i = 1; i < other.nodes.size(); i++) {
+            Node node = other.nodes[i];
+            if (node.parent) node.parent += shift;
+            if (node.child) node.child += shift;
+            if (node.sibling) node.sibling += shift;
+            node.item += itemShift;
+            nodes.push_back(node);
+        }
+        for (size_t i = 1; i < other.items.size(); i++) {
+            items.push_back(Item{other.items[i].node + shift, other.items[i].value});
+        }
+        for (Index i : other.freeNodes) freeNodes.push_back(i + shift);
+        for (Index i : other.freeItems) freeItems.push_back(i + itemShift);
+        return shift;
+    }
 
-        Node* minNode = findMin();
-        Node* prevMin = nullptr, *curr = head;
+public:
+    // Index of the entry's item; stays valid until the entry is extracted
+    // or erased
+    typedef Index Handle;
+
+    explicit BinomialHeap(bool lazyInsert = false): nodes(1), items(1), head(NIL), minNode(NIL), lazy(lazyInsert) {}
+
+    // Empty the heap in O(1), keeping the slabs' capacity for reuse
+    void clear() {
+        nodes.resize(1);
+        items.resize(1);
+        freeNodes.clear();
+        freeItems.clear();
+        head = minNode = NIL;
+    }
 
-        while (curr->sibling && curr->sibling != minNode) {
-            curr = curr->sibling;
+    Handle insert(int key, int value = 0) {
+        Index item = newItem(value);
+        Index temp = newNode(key, item);
+        items[item].node = temp;
+        if (!minNode || key < nodes[minNode].key) minNode = temp;
+        if (lazy) {
+            nodes[temp].sibling = head;
+            head = temp;
+        } else {
+            head = unionHeaps(head, temp);
+            linkTrees(head);
         }
+        return item;
+    }
+
+    // Smallest key, or INT_MAX if the heap is empty
+    int findMin() {
+        return minNode ? nodes[minNode].key : INT_MAX;
+    }
+
+    bool empty() {
+        return head == NIL;
+    }
+
+    // Handle of the minimum entry, or NIL if the heap is empty
+    Handle top() {
+        return minNode ? nodes[minNode].item : NIL;
+    }
+
+    int key(Handle h) {
+        return nodes[items[h].node].key;
+    }
 
-        if (curr == minNode) head = minNode->sibling;
-        else curr->sibling = minNode->sibling;
+    int value(Handle h) {
+        return items[h].value;
+    }
+
+    int extractMin() {
+        if (!head) return INT_MAX;
+        return removeRoot(minNode);
+    }
 
-        Node* child = reverseList(minNode->child);
-        head = unionHeaps(head, child);
-        linkTrees(head);
+    // Lower the key of an entry; a larger newKey is ignored
+    void decreaseKey(Handle h, int newKey) {
+        Index node = items[h].node;
+        if (newKey > nodes[node].key) return;
+        nodes[node].key = newKey;
+        bubbleUp(node, false);
+    }
 
-        int minVal = minNode->key;
-        delete minNode;
-        return minVal;
+    // Remove any entry: bubble it to its root as if its key were -infinity,
+    // then take that root out like extractMin does
+    void erase(Handle h) {
+        removeRoot(bubbleUp(items[h].node, true));
+    }
+
+    // Move every entry of other into this heap, leaving other empty.
+    //
+    // Cost: nodes live in their heap's slabs, so unless this heap is empty
+    // (when it takes other's slabs over in O(1)) other's slabs are copied
+    // and re-indexed, which is O(size of other) rather than the O(log n) of
+    // a pointer-based binomial heap. Meld the larger heap into the smaller
+    // one only when that is affordable.
+    //
+    // Handles: a handle h into other is h + the returned shift in this heap
+    // afterwards. The shift is 0 when this heap was empty; handles into this
+    // heap are never affected.
+    //
+    // A lazy heap then splices the root lists, an eager one merges them by
+    // degree, or consolidates when other is lazy and its roots are unordered.
+    Index meld(BinomialHeap& other) {
+        if (!other.head || &other == this) return 0;
+        Index otherHead = other.head;
+        Index otherMin = other.minNode;
+        Index itemShift = 0;
+        if (!head) {
+            swap(nodes, other.nodes);
+            swap(items, other.items);
+            swap(freeNodes, other.freeNodes);
+            swap(freeItems, other.freeItems);
+        } else {
+            Index shift = adopt(other, itemShift);
+            otherHead += shift;
+            otherMin += shift;
+        }
+        bool otherLazy = other.lazy;
+        other.clear();
+
+        if (lazy) {
+            Index tail = otherHead;
+            while (nodes[tail].sibling) tail = nodes[tail].sibling;
+            nodes[tail].sibling = head;
+            head = otherHead;
+            if (!minNode || nodes[otherMin].key < nodes[minNode].key) minNode = otherMin;
+        } else if (otherLazy) {
+            consolidate(head, otherHead, NIL);
+        } else {
+            if (!minNode || nodes[otherMin].key < nodes[minNode].key) minNode = otherMin;
+            head = unionHeaps(head, otherHead);
+            linkTrees(head);
+        }
+        return itemShift;
     }
 
     void display() {
         cout << "Binomial Heap:\n";
-        Node* temp = head;
+        Index temp = head;
         while (temp) {
-            cout << "B" << temp->degree << ": ";
+            cout << "B" << nodes[temp].degree << ": ";
             printTree(temp);
             cout << "\n";
-            temp = temp->sibling;
+            temp = nodes[temp].sibling;
+        }
+    }
+
+    // Preorder walk of one tree with an explicit stack, so deep or wide
+    // heaps cannot overflow the call stack
+    void printTree(Index root) {
+        vector<Index> stack{root};
+        while (!stack.empty()) {
+            Index node = stack.back();
+            stack.pop_back();
+            cout << nodes[node].key << " ";
+            // A node's later siblings go under its children, which print first
+            if (node != root && nodes[node].sibling) stack.push_back(nodes[node].sibling);
+            if (nodes[node].child) stack.push_back(nodes[node].child);
+        }
+    }
+};
+
+// Default-constructible lazy variant, so the benchmark harness can build it
+// like any other heap
+struct LazyBinomialHeap : BinomialHeap {
+    LazyBinomialHeap(): BinomialHeap(true) {}
+};
+
+struct PairingNode {
+    int key, value;
+    // prev is the left sibling, or the parent for a first child
+    PairingNode *child, *sibling, *prev;
+};
+
+// Pairing heap: one heap-ordered multiway tree kept as child/sibling lists.
+// Insert, meld and decreaseKey are a single link; extractMin pairs up the
+// root's children left to right and folds the pairs back right to left.
+class PairingHeap {
+    PairingNode* root;
+
+    // Both a and b are roots with no siblings
+    PairingNode* link(PairingNode* a, PairingNode* b) {
+        if (b->key < a->key) swap(a, b);
+        b->sibling = a->child;
+        if (a->child) a->child->prev = b;
+        b->prev = a;
+        a->child = b;
+        return a;
+    }
+
+    // Two-pass combine of a sibling list into one tree, without recursion:
+    // the first pass stacks the linked pairs through their sibling pointers
+    PairingNode* combine(PairingNode* first) {
+        if (!first) return nullptr;
+        PairingNode* pairs = nullptr;
+        while (first) {
+            PairingNode* a = first;
+            PairingNode* b = a->sibling;
+            first = b ? b->sibling : nullptr;
+            a->sibling = a->prev = nullptr;
+            if (b) {
+                b->sibling = b->prev = nullptr;
+                a = link(a, b);
+            }
+            a->sibling = pairs;
+            pairs = a;
+        }
+
+        PairingNode* tree = pairs;
+        pairs = pairs->sibling;
+        tree->sibling = nullptr;
+        while (pairs) {
+            PairingNode* next = pairs->sibling;
+            pairs->sibling = nullptr;
+            tree = link(tree, pairs);
+            pairs = next;
+        }
+        return tree;
+    }
+
+    // Detach a non-root node, with its subtree, from its parent
+    void cut(PairingNode* node) {
+        if (node->prev->child == node) node->prev->child = node->sibling;
+        else node->prev->sibling = node->sibling;
+        if (node->sibling) node->sibling->prev = node->prev;
+        node->sibling = node->prev = nullptr;
+    }
+
+public:
+    typedef PairingNode* Handle;
+
+    PairingHeap(): root(nullptr) {}
+
+    ~PairingHeap() {
+        vector<PairingNode*> stack;
+        if (root) stack.push_back(root);
+        while (!stack.empty()) {
+            PairingNode* node = stack.back();
+            stack.pop_back();
+            if (node->child) stack.push_back(node->child);
+            if (node->sibling) stack.push_back(node->sibling);
+            delete node;
+        }
+    }
+
+    PairingHeap(const PairingHeap&) = delete;
+    PairingHeap& operator=(const PairingHeap&) = delete;
+
+    Handle insert(int key, int value = 0) {
+        PairingNode* node = new PairingNode{key, value, nullptr, nullptr, nullptr};
+        root = root ? link(root, node) : node;
+        return node;
+    }
+
+    bool empty() {
+        return root == nullptr;
+    }
+
+    Handle top() {
+        return root;
+    }
+
+    int key(Handle h) {
+        return h->key;
+    }
+
+    int value(Handle h) {
+        return h->value;
+    }
+
+    int extractMin() {
+        if (!root) return INT_MAX;
+        PairingNode* old = root;
+        root = combine(root->child);
+        int key = old->key;
+        delete old;
+        return key;
+    }
+
+    void decreaseKey(Handle h, int newKey) {
+        if (newKey > h->key) return;
+        h->key = newKey;
+        if (h == root) return;
+        cut(h);
+        root = link(root, h);
+    }
+
+    void erase(Handle h) {
+        if (h == root) {
+            extractMin();
+            return;
+        }
+        cut(h);
+        PairingNode* rest = combine(h->child);
+        if (rest) root = link(root, rest);
+        delete h;
+    }
+
+    // Handles into other stay valid
+    void meld(PairingHeap& other) {
+        if (!other.root || &other == this) return;
+        root = root ? link(root, other.root) : other.root;
+        other.root = nullptr;
+    }
+};
+
+// Monotone radix heap for non-negative keys that never drop below the last
+// extracted minimum, as in Dijkstra. Bucket 0 holds keys equal to last and
+// bucket b keys whose highest bit differing from last is b - 1. extractMin
+// empties the lowest non-empty bucket into lower ones around its minimum, so
+// each entry moves down at most 31 times over its life.
+class RadixHeap {
+    struct Entry {
+        int key, value;
+        int bucket, pos;
+    };
+
+    static const int BUCKETS = 32;
+
+    vector<Entry> entries;
+    vector<int> freeSlots;
+    vector<int> buckets[BUCKETS];
+    int last;
+    size_t count;
+
+    int bucketOf(int key) {
+        if (key == last) return 0;
+        return 32 - __builtin_clz(static_cast<unsigned>(key ^ last));
+    }
+
+    void place(int id) {
+        Entry& entry = entries[id];
+        entry.bucket = bucketOf(entry.key);
+        entry.pos = static_cast<int>(buckets[entry.bucket].size());
+        buckets[entry.bucket].push_back(id);
+    }
+
+    void unplace(int id) {
+        Entry& entry = entries[id];
+        vector<int>& bucket = buckets[entry.bucket];
+        int moved = bucket.back();
+        bucket[entry.pos] = moved;
+        entries[moved].pos = entry.pos;
+        bucket.pop_back();
+    }
+
+
+public:
+    // Index into the entry table, reused once its entry is gone
+    typedef int Handle;
+
+    RadixHeap(): last(0), count(0) {}
+
+    // key must not be below the last extracted minimum
+    Handle insert(int key, int value = 0) {
+        int id;
+        if (freeSlots.empty()) {
+            id = static_cast<int>(entries.size());
+            entries.push_back(Entry());
+        } else {
+            id = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        entries[id].key = key;
+        entries[id].value = value;
+        place(id);
+        count++;
+        return id;
+    }
+
+    bool empty() {
+        return count == 0;
+    }
+
+    // Leaves last alone: moving it up to the current minimum here would
+    // misplace a later key between the two, which the precondition allows
+    Handle top() {
+        if (!count) return -1;
+        int b = 0;
+        while (buckets[b].empty()) b++;
+        int best = buckets[b].back();
+        if (b == 0) return best;
+        for (int id : buckets[b]) {
+            if (entries[id].key < entries[best].key) best = id;
+        }
+        return best;
+    }
+
+    int key(Handle h) {
+        return entries[h].key;
+    }
+
+    int value(Handle h) {
+        return entries[h].value;
+    }
+
+    // Takes the entry top() names, moving last up to its key
+    int extractMin() {
+        if (!count) return INT_MAX;
+        int id = top();
+        int b = entries[id].bucket;
+        unplace(id);
+        if (b > 0) {
+            vector<int>& from = buckets[b];
+            last = entries[id].key;
+            // Everything left here now agrees with last above bit b - 1, so
+            // it all lands in lower buckets and from is not touched while we
+            // walk it
+            for (int rest : from) place(rest);
+            from.clear();
+        }
+        freeSlots.push_back(id);
+        count--;
+        return entries[id].key;
+    }
+
+    // newKey must not be below the last extracted minimum
+    void decreaseKey(Handle h, int newKey) {
+        if (newKey > entries[h].key) return;
+        unplace(h);
+        entries[h].key = newKey;
+        place(h);
+    }
+
+    void erase(Handle h) {
+        unplace(h);
+        freeSlots.push_back(h);
+        count--;
+    }
+
+    // Radix heaps do not link, so this reinserts every entry of other, which
+    // must not hold keys below this heap's last extracted minimum. Handles
+    // into other are invalidated.
+    void meld(RadixHeap& other) {
+        if (&other == this) return;
+        for (auto& bucket : other.buckets) {
+            for (int id : bucket) insert(other.entries[id].key, other.entries[id].value);
+            bucket.clear();
         }
+        other.entries.clear();
+        other.freeSlots.clear();
+        other.count = 0;
+        other.last = 0;
+    }
+};
+
+// std::priority_queue behind the part of the interface it can offer: no
+// handles, so no decreaseKey or erase, and meld pushes the smaller queue
+// into the larger one
+class StdHeap {
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+
+public:
+    void insert(int key, int value = 0) {
+        pq.push({key, value});
+    }
+
+    bool empty() {
+        return pq.empty();
     }
 
-    void printTree(Node* node) {
-        if (node == nullptr) return;
-        cout << node->key << " ";
-        printTree(node->child);
-        printTree(node->sibling);
+    int extractMin() {
+        if (pq.empty()) return INT_MAX;
+        int key = pq.top().first;
+        pq.pop();
+        return key;
+    }
+
+    void meld(StdHeap& other) {
+        if (pq.size() < other.pq.size()) swap(pq, other.pq);
+        while (!other.pq.empty()) {
+            pq.push(other.pq.top());
+            other.pq.pop();
+        }
     }
 };
 
-int main() {
+// The heaps above share one interface, used by the templated workloads below:
+//   Handle insert(key, value)   handle stays valid until its entry leaves or
+//                               its heap is melded into another
+//   bool empty()
+//   Handle top()                entry with the smallest key
+//   int key(h), int value(h)
+//   int extractMin()            returns the smallest key
+//   void decreaseKey(h, key)
+//   void erase(h)
+//   meld(other)                 moves other's entries in, leaving it empty
+// Keys fed to RadixHeap must respect its monotone precondition, which every
+// workload here does.
+//
+// Handles from other are not portable across meld, so generic code must not
+// keep them:
+//   BinomialHeap, LazyBinomialHeap
+//                  meld returns an Index shift; h from other becomes h + shift
+//   PairingHeap    meld returns void; handles from other stay valid
+//   RadixHeap      meld returns void; handles from other are invalidated
+//   StdHeap        has no handles
+
+typedef vector<vector<pair<int, int>>> Graph;
+
+// Order-sensitive hash of the extracted keys, to check all heaps agree
+void mix(unsigned long long& checksum, int key) {
+    checksum = checksum * 1000003 + static_cast<unsigned>(key);
+}
+
+double elapsedMs(chrono::steady_clock::time_point start) {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Heapsort: insert every key, then extract them all
+template<typename Heap>
+double timeInsertExtract(const vector<int>& keys, unsigned long long& checksum) {
+    auto start = chrono::steady_clock::now();
+    Heap heap;
+    for (int key : keys) {
+        heap.insert(key);
+    }
+    checksum = 0;
+    while (!heap.empty()) {
+        mix(checksum, heap.extractMin());
+    }
+    return elapsedMs(start);
+}
+
+// Hold model of an event queue: a steady `size` entries, each operation
+// extracting the earliest and scheduling a later one
+template<typename Heap>
+double timeHold(int size, int ops, unsigned long long& checksum) {
+    mt19937 rng(7);
+    auto start = chrono::steady_clock::now();
+    Heap heap;
+    for (int i = 0; i < size; i++) {
+        heap.insert(static_cast<int>(rng() % 1000));
+    }
+    checksum = 0;
+    for (int i = 0; i < ops; i++) {
+        int key = heap.extractMin();
+        mix(checksum, key);
+        heap.insert(key + static_cast<int>(rng() % 1000));
+    }
+    return elapsedMs(start);
+}
+
+// Meld-heavy: `heaps` small heaps over the keys, melded pairwise in rounds
+// down to one, which is then drained
+template<typename Heap>
+double timeMeld(const vector<int>& keys, int heaps, unsigned long long& checksum) {
+    auto start = chrono::steady_clock::now();
+    vector<Heap> parts(heaps);
+    for (size_t i = 0; i < keys.size(); i++) {
+        parts[i % heaps].insert(keys[i]);
+    }
+    for (int step = 1; step < heaps; step *= 2) {
+        for (int i = 0; i + step < heaps; i += 2 * step) {
+            parts[i].meld(parts[i + step]);
+        }
+    }
+    checksum = 0;
+    while (!parts[0].empty()) {
+        mix(checksum, parts[0].extractMin());
+    }
+    return elapsedMs(start);
+}
+
+// Dijkstra from vertex 0 with one entry per vertex, lowered by decreaseKey
+template<typename Heap>
+double timeDijkstra(const Graph& adj, vector<long long>& dist) {
+    int n = static_cast<int>(adj.size());
+    auto start = chrono::steady_clock::now();
+    dist.assign(n, LLONG_MAX);
+    vector<typename Heap::Handle> handles(n);
+    // 0 unseen, 1 queued, 2 settled
+    vector<char> state(n, 0);
+    Heap heap;
+    dist[0] = 0;
+    handles[0] = heap.insert(0, 0);
+    state[0] = 1;
+    while (!heap.empty()) {
+        int u = heap.value(heap.top());
+        heap.extractMin();
+        state[u] = 2;
+        for (auto& edge : adj[u]) {
+            int v = edge.first;
+            long long nd = dist[u] + edge.second;
+            if (state[v] == 2 || nd >= dist[v]) continue;
+            dist[v] = nd;
+            if (state[v] == 1) {
+                heap.decreaseKey(handles[v], static_cast<int>(nd));
+            } else {
+                handles[v] = heap.insert(static_cast<int>(nd), v);
+                state[v] = 1;
+            }
+        }
+    }
+    return elapsedMs(start);
+}
+
+// Dijkstra for priority_queue, which has no decreaseKey: push a duplicate
+// per improvement and skip stale entries when they surface
+double timeQueueDijkstra(const Graph& adj, vector<long long>& dist) {
+    auto start = chrono::steady_clock::now();
+    dist.assign(adj.size(), LLONG_MAX);
+    priority_queue<pair<long long, int>, vector<pair<long long, int>>, greater<pair<long long, int>>> pq;
+    dist[0] = 0;
+    pq.push({0, 0});
+    while (!pq.empty()) {
+        auto [d, u] = pq.top();
+        pq.pop();
+        if (d > dist[u]) continue;
+        for (auto& edge : adj[u]) {
+            long long nd = d + edge.second;
+            if (nd < dist[edge.first]) {
+                dist[edge.first] = nd;
+                pq.push({nd, edge.first});
+            }
+        }
+    }
+    return elapsedMs(start);
+}
+
+// Random connected graph: a random tree plus extra random edges
+Graph randomGraph(int n, int m) {
+    mt19937 rng(12);
+    Graph adj(n);
+    for (int i = 1; i < n; i++) {
+        adj[rng() % i].push_back({i, static_cast<int>(rng() % 1000) + 1});
+    }
+    for (int i = n - 1; i < m; i++) {
+        adj[rng() % n].push_back({static_cast<int>(rng() % n), static_cast<int>(rng() % 1000) + 1});
+    }
+    return adj;
+}
+
+struct Workloads {
+    vector<int> keys;
+    int holdSize, holdOps, meldHeaps;
+    Graph graph;
+    // Results from priority_queue that every other heap must reproduce
+    unsigned long long sorted, held, melded;
+    vector<long long> dist;
+};
+
+template<typename Heap>
+void benchmarkHeap(const char* name, const Workloads& w) {
+    unsigned long long sorted, held, melded;
+    vector<long long> dist;
+    double sortMs = timeInsertExtract<Heap>(w.keys, sorted);
+    double holdMs = timeHold<Heap>(w.holdSize, w.holdOps, held);
+    double dijkstraMs = timeDijkstra<Heap>(w.graph, dist);
+    double meldMs = timeMeld<Heap>(w.keys, w.meldHeaps, melded);
+    bool ok = sorted == w.sorted && held == w.held && dist == w.dist && melded == w.melded;
+    cout << name << ": insert/extract " << sortMs << " ms, hold " << holdMs << " ms, dijkstra " << dijkstraMs
+         << " ms, meld " << meldMs << " ms" << (ok ? "" : " (mismatch)") << endl;
+}
+
+// Every heap against priority_queue on n random keys: heapsort, a hold model
+// queue, Dijkstra with decreaseKey on n vertices and 10n edges, and melding
+// n / 16 small heaps
+void benchmarkHeaps(int n) {
+    Workloads w;
+    mt19937 rng(4);
+    w.keys.resize(n);
+    for (int& key : w.keys) {
+        key = static_cast<int>(rng() % 1000000000);
+    }
+    w.holdSize = 1 << 16;
+    w.holdOps = n;
+    w.meldHeaps = max(1, n / 16);
+    w.graph = randomGraph(n, 10 * n);
+
+    double sortMs = timeInsertExtract<StdHeap>(w.keys, w.sorted);
+    double holdMs = timeHold<StdHeap>(w.holdSize, w.holdOps, w.held);
+    double dijkstraMs = timeQueueDijkstra(w.graph, w.dist);
+    double meldMs = timeMeld<StdHeap>(w.keys, w.meldHeaps, w.melded);
+    cout << n << " keys" << endl;
+    cout << "priority_queue: insert/extract " << sortMs << " ms, hold " << holdMs << " ms, dijkstra " << dijkstraMs
+         << " ms (lazy deletion), meld " << meldMs << " ms" << endl;
+
+    benchmarkHeap<BinomialHeap>("binomial heap", w);
+    benchmarkHeap<LazyBinomialHeap>("lazy binomial heap", w);
+    benchmarkHeap<PairingHeap>("pairing heap", w);
+    benchmarkHeap<RadixHeap>("radix heap", w);
+}
+
+// Event queue fed mostly by inserts: rounds of `burst` inserts and one
+// extractMin, against pushing the same keys onto a vector
+void benchmarkInserts(int n, int burst) {
+    mt19937 rng(4);
+    vector<int> keys(n);
+    for (int& key : keys) {
+        key = static_cast<int>(rng() % 1000000000);
+    }
+
+    auto start = chrono::steady_clock::now();
+    vector<int> pushed;
+    for (int key : keys) {
+        pushed.push_back(key);
+    }
+    double vectorMs = elapsedMs(start);
+
+    cout << n << " inserts, one extractMin per " << burst << ": vector push " << vectorMs << " ms";
+    long long checksums[2] = {0, 0};
+    for (bool lazy : {false, true}) {
+        start = chrono::steady_clock::now();
+        {
+            BinomialHeap heap(lazy);
+            for (int i = 0; i < n; i++) {
+                heap.insert(keys[i]);
+                if (i % burst == burst - 1) checksums[lazy] += heap.extractMin();
+            }
+        }
+        double ms = elapsedMs(start);
+        cout << ", " << (lazy ? "lazy" : "eager") << " heap " << ms << " ms";
+    }
+    cout << (checksums[0] == checksums[1] ? "" : " (mismatch)") << " [" << checksums[0] << "]" << endl;
+}
+
+// Meld an n-entry heap into an empty heap (slab takeover) and into a
+// small one (slab copy), then lower every melded entry through its old
+// handle plus meld's shift and check the heap drains in order
+void benchmarkMeldCost(int n) {
+    mt19937 rng(4);
+    cout << "meld of " << n << " entries";
+    for (int into : {0, 1000}) {
+        BinomialHeap big, heap;
+        vector<BinomialHeap::Handle> handles(n);
+        for (int i = 0; i < n; i++) {
+            handles[i] = big.insert(static_cast<int>(rng() % 1000000000) + 1000000, i);
+        }
+        for (int i = 0; i < into; i++) {
+            heap.insert(static_cast<int>(rng() % 1000000000) + 1000000, -1);
+        }
+        auto start = chrono::steady_clock::now();
+        BinomialHeap::Handle shift = heap.meld(big);
+        double ms = elapsedMs(start);
+        bool ok = big.empty() && (into > 0 || shift == 0);
+        for (int i = 0; i < n && ok; i++) {
+            BinomialHeap::Handle h = handles[i] + shift;
+            ok = heap.value(h) == i;
+            heap.decreaseKey(h, i);
+        }
+        for (int i = 0; i < n && ok; i++) {
+            ok = heap.value(heap.top()) == i && heap.extractMin() == i;
+        }
+        cout << ", into " << into << " entries " << ms << " ms" << (ok ? "" : " (mismatch)");
+    }
+    cout << endl;
+}
+
+void runBenchmarks() {
+    for (int burst : {1000000000, 64, 8}) {
+        benchmarkInserts(10000000, burst);
+    }
+    benchmarkHeaps(100000);
+    benchmarkHeaps(1000000);
+    benchmarkMeldCost(1000000);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        runBenchmarks();
+        return 0;
+    }
+
     BinomialHeap bh;
     
 
@@ -175,5 +995,48 @@ int main() {
 
     bh.display();
 
+    BinomialHeap::Handle h = bh.insert(40);
+    BinomialHeap::Handle gone = bh.insert(15);
+    bh.decreaseKey(h, 2);
+    bh.erase(gone);
+    cout << "\nAfter decreaseKey(40 -> 2) and erase(15), extracted: " << bh.extractMin();
+    cout << " " << bh.extractMin() << endl;
+
+    PairingHeap ph, other;
+    ph.insert(8);
+    ph.insert(3);
+    PairingHeap::Handle ph12 = other.insert(12);
+    other.insert(6);
+    ph.meld(other);
+    ph.decreaseKey(ph12, 1);
+    cout << "\nPairing heap after meld and decreaseKey(12 -> 1):";
+    while (!ph.empty()) cout << " " << ph.extractMin();
+    cout << endl;
+
+    RadixHeap rh;
+    for (int key : {50, 7, 23, 7}) rh.insert(key);
+    cout << "Radix heap:";
+    while (!rh.empty()) cout << " " << rh.extractMin();
+    cout << endl;
+
+    // Keys between the last extracted minimum and the current one stay
+    // legal after top()
+    RadixHeap rt;
+    rt.insert(10);
+    rt.insert(20);
+    RadixHeap::Handle rt30 = rt.insert(30);
+    RadixHeap::Handle rt40 = rt.insert(40);
+    rt.extractMin();
+    rt.top();
+    rt.insert(15);
+    rt.erase(rt30);
+    rt.top();
+    rt.decreaseKey(rt40, 12);
+    vector<int> drained;
+    while (!rt.empty()) drained.push_back(rt.extractMin());
+    cout << "Radix heap after top(), insert(15) and decreaseKey(40 -> 12):";
+    for (int key : drained) cout << " " << key;
+    cout << (drained == vector<int>{12, 15, 20} ? "" : " (out of order)") << endl;
+
     return 0;
 }
@@ -7,10 +7,178 @@
 #include <queue>
 #include <limits>
 #include <utility>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
 
 using namespace std;
 
 
+// Heap operations done by one dijkstra run
+struct QueueStats {
+    long long inserts = 0, decreases = 0, pops = 0;
+};
+
+
+// priority_queue with lazy deletion: lowering a vertex pushes a duplicate
+// and leaves the old entry for dijkstra's stale check to skip
+class LazyQueue {
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    
+public:
+    QueueStats stats;
+    
+    LazyQueue(int) {}
+    
+    bool empty() {
+        return pq.empty();
+    }
+    
+    void push(int v, int d) {
+        stats.inserts++;
+        pq.push(make_pair(d, v));
+    }
+    
+    pair<int, int> pop() {
+        stats.pops++;
+        pair<int, int> top = pq.top();
+        pq.pop();
+        return top;
+    }
+};
+
+
+// Allocates on 64-byte boundaries, so index i of a vector sits at a known
+// offset within its cache line
+template<typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+    
+    CacheAlignedAllocator() {}
+    
+    template<typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+    
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(64)));
+    }
+    
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(64));
+    }
+    
+    template<typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const {
+        return true;
+    }
+    
+    template<typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const {
+        return false;
+    }
+};
+
+
+// Indexed D-ary min-heap over vertices 0..n-1. The position map lets push
+// lower a queued vertex in place, so each vertex has at most one entry.
+// Keys sit next to their vertex in the heap array, so sifting never leaves
+// it. The root is stored at index D - 1 behind D - 1 unused slots, which
+// puts every sibling group at a multiple of D; with 8-byte entries in a
+// cache-aligned array, a node's children then share one cache line
+// whenever D divides 8.
+template<int D>
+class IndexedHeap {
+    static const int kRoot = D - 1;
+    
+    vector<pair<int, int>, CacheAlignedAllocator<pair<int, int>>> heap;
+    // Index of each vertex in heap, or -1 when it is not queued
+    vector<int> pos;
+    
+    static int parentOf(int i) {
+        return i / D + D - 2;
+    }
+    
+    static int firstChildOf(int i) {
+        return D * (i - D + 2);
+    }
+    
+    void place(int i, pair<int, int> entry) {
+        heap[i] = entry;
+        pos[entry.second] = i;
+    }
+    
+    void siftUp(int i) {
+        pair<int, int> entry = heap[i];
+        while (i > kRoot) {
+            int parent = parentOf(i);
+            if (heap[parent].first <= entry.first) break;
+            place(i, heap[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+    
+    void siftDown(int i) {
+        pair<int, int> entry = heap[i];
+        int n = heap.size();
+        while (true) {
+            int first = firstChildOf(i);
+            if (first >= n) break;
+            int best = first;
+            int last = min(first + D, n);
+            for (int c = first + 1; c < last; c++) {
+                if (heap[c].first < heap[best].first) best = c;
+            }
+            if (heap[best].first >= entry.first) break;
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, entry);
+    }
+    
+public:
+    QueueStats stats;
+    
+    IndexedHeap(int n) : pos(n, -1) {
+        heap.reserve(kRoot + n);
+        heap.resize(kRoot);
+    }
+    
+    bool empty() {
+        return static_cast<int>(heap.size()) == kRoot;
+    }
+    
+    // Queue v with key d, or lower its key to d if it is already queued
+    void push(int v, int d) {
+        if (pos[v] < 0) {
+            stats.inserts++;
+            heap.push_back(make_pair(d, v));
+            siftUp(heap.size() - 1);
+        } else {
+            stats.decreases++;
+            heap[pos[v]].first = d;
+            siftUp(pos[v]);
+        }
+    }
+    
+    pair<int, int> pop() {
+        stats.pops++;
+        pair<int, int> top = heap[kRoot];
+        pos[top.second] = -1;
+        pair<int, int> last = heap.back();
+        heap.pop_back();
+        if (!empty()) {
+            heap[kRoot] = last;
+            siftDown(kRoot);
+        }
+        return top;
+    }
+};
+
+
 class Graph {
     int V; 
     vector<vector<pair<int, int>>> adj; 
@@ -27,23 +195,30 @@ public:
     }
     
     
-    vector<int> dijkstra(int src) {
+    // Queue is LazyQueue or IndexedHeap<D>: push(v, d) queues v or lowers
+    // its key, pop() returns the (distance, vertex) entry with the smallest
+    // distance
+    template<typename Queue = IndexedHeap<4>>
+    vector<int> dijkstra(int src, QueueStats* stats = nullptr) {
         
         
-        priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+        Queue pq(V);
         
         
         vector<int> dist(V, numeric_limits<int>::max());
         
         
-        pq.push(make_pair(0, src));
+        pq.push(src, 0);
         dist[src] = 0;
         
         
         while (!pq.empty()) {
             
-            int u = pq.top().second;
-            pq.pop();
+            pair<int, int> top = pq.pop();
+            int u = top.second;
+            
+            // Entry left behind when u was lowered, and u already relaxed
+            if (top.first > dist[u]) continue;
             
             
             for (auto& edge : adj[u]) {
@@ -54,11 +229,12 @@ public:
                 if (dist[v] > dist[u] + weight) {
                     
                     dist[v] = dist[u] + weight;
-                    pq.push(make_pair(dist[v], v));
+                    pq.push(v, dist[v]);
                 }
             }
         }
         
+        if (stats) *stats = pq.stats;
         return dist;
     }
     
@@ -72,7 +248,59 @@ public:
 };
 
 
-int main() {
+// Road-style network: a side x side grid of intersections, each joined to
+// its right and lower neighbours by a road of random length 1..1000, with
+// one road in ten missing
+Graph roadGrid(int side) {
+    mt19937 rng(side);
+    Graph g(side * side);
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int u = r * side + c;
+            if (c + 1 < side && rng() % 10) g.addEdge(u, u + 1, rng() % 1000 + 1);
+            if (r + 1 < side && rng() % 10) g.addEdge(u, u + side, rng() % 1000 + 1);
+        }
+    }
+    return g;
+}
+
+
+template<typename Queue>
+void benchmarkQueue(Graph& g, const char* name, const vector<int>& expected) {
+    QueueStats stats;
+    auto start = chrono::steady_clock::now();
+    vector<int> dist = g.dijkstra<Queue>(0, &stats);
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "  " << name << ": " << ms << " ms, " << stats.inserts << " inserts, " << stats.decreases
+         << " decreases, " << stats.pops << " pops" << (dist == expected ? "" : " (mismatch)") << endl;
+}
+
+
+void runBenchmarks(const vector<int>& sides) {
+    for (int side : sides) {
+        Graph g = roadGrid(side);
+        vector<int> expected = g.dijkstra<LazyQueue>(0);
+        cout << side << " x " << side << " road grid" << endl;
+        benchmarkQueue<LazyQueue>(g, "priority_queue, lazy deletion", expected);
+        benchmarkQueue<IndexedHeap<2>>(g, "indexed binary heap", expected);
+        benchmarkQueue<IndexedHeap<4>>(g, "indexed 4-ary heap", expected);
+        benchmarkQueue<IndexedHeap<8>>(g, "indexed 8-ary heap", expected);
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        vector<int> sides;
+        for (int i = 2; i < argc; i++) {
+            sides.push_back(atoi(argv[i]));
+        }
+        if (sides.empty()) {
+            sides = {1000, 2000};
+        }
+        runBenchmarks(sides);
+        return 0;
+    }
     
     Graph g(9);
     
@@ -1,177 +1,2194 @@
 // Hash Table Implementation in C++
-// This implementation uses separate chaining to handle collisions
+// The default engine uses separate chaining to handle collisions; the
+// SwissTable engine uses open addressing over flat storage instead
 
 #include <iostream>
 #include <list>
 #include <vector>
 #include <functional>
 #include <string>
+#include <string_view>
+#include <memory>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <cstring>
+#include <type_traits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 using namespace std;
 
-// Template Hash Table class
-template<typename K, typename V>
+// Storage engines, selected through the third template parameter
+struct Chaining {};     // vector of per-bucket linked lists
+struct SwissTable {};   // open addressing with grouped control bytes
+
+// Spread the bits of a std::hash value, which is the identity for integers
+inline size_t mixHash(size_t hashValue) {
+    uint64_t h = static_cast<uint64_t>(hashValue);
+    h ^= h >> 32;
+    h *= 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(h ^ (h >> 29));
+}
+
+// wyhash-style primitives: a 64x64->128 bit multiply folded back to 64 bits
+// mixes every input bit into the low bits a power-of-two table masks off
+namespace fasthash {
+
+const uint64_t kSecret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+                             0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+inline uint64_t fold(uint64_t a, uint64_t b) {
+    __uint128_t product = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline uint64_t read8(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t read4(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Hash a byte string 16 or 48 bytes per round, following wyhash
+inline uint64_t hashBytes(const char* p, size_t length, uint64_t seed = 0) {
+    seed ^= fold(seed ^ kSecret[0], kSecret[1]);
+    uint64_t a, b;
+    if (length <= 16) {
+        if (length >= 4) {
+            size_t mid = (length >> 3) << 2;
+            a = (read4(p) << 32) | read4(p + mid);
+            b = (read4(p + length - 4) << 32) | read4(p + length - 4 - mid);
+        } else if (length > 0) {
+            a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+                (static_cast<uint64_t>(static_cast<uint8_t>(p[length >> 1])) << 8) |
+                static_cast<uint8_t>(p[length - 1]);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t remaining = length;
+        if (remaining > 48) {
+            uint64_t seed1 = seed, seed2 = seed;
+            do {
+                seed = fold(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+                seed1 = fold(read8(p + 16) ^ kSecret[2], read8(p + 24) ^ seed1);
+                seed2 = fold(read8(p + 32) ^ kSecret[3], read8(p + 40) ^ seed2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = fold(read8(p) ^ kSecret[1], read8(p + 8) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+        a = read8(p + remaining - 16);
+        b = read8(p + remaining - 8);
+    }
+    
+    __uint128_t product = static_cast<__uint128_t>(a ^ kSecret[1]) * (b ^ seed);
+    return fold(static_cast<uint64_t>(product) ^ kSecret[0] ^ length,
+                static_cast<uint64_t>(product >> 64) ^ kSecret[1]);
+}
+
+} // namespace fasthash
+
+// Default hasher of the tables. Its output is already well mixed, which it
+// advertises with is_avalanching so the tables can use it without remixing.
+// Other types go through std::hash and mixHash.
+template<typename K, typename Enable = void>
+struct FastHash {
+    typedef void is_avalanching;
+    
+    size_t operator()(const K& key) const {
+        return mixHash(hash<K>{}(key));
+    }
+};
+
+// Integers and enums: a single multiply-fold
+template<typename K>
+struct FastHash<K, typename enable_if<is_integral<K>::value || is_enum<K>::value>::type> {
+    typedef void is_avalanching;
+    
+    size_t operator()(K key) const {
+        return fasthash::fold(static_cast<uint64_t>(key) ^ fasthash::kSecret[0], fasthash::kSecret[1]);
+    }
+};
+
+// Strings: wyhash over the bytes. Transparent, so string_view and const
+// char* keys hash to the same value as the equal std::string and can be
+// looked up without constructing a temporary string.
+template<>
+struct FastHash<string> {
+    typedef void is_avalanching;
+    typedef void is_transparent;
+    
+    size_t operator()(string_view key) const {
+        return fasthash::hashBytes(key.data(), key.size());
+    }
+};
+
+template<typename H, typename = void>
+struct IsAvalanching : false_type {};
+
+template<typename H>
+struct IsAvalanching<H, typename H::is_avalanching> : true_type {};
+
+// Hash value a table may reduce with a mask. Hashers that do not declare
+// themselves avalanching (std::hash, for one) are mixed first.
+template<typename H, typename Q>
+size_t tableHash(const H& hasher, const Q& key) {
+    size_t hashValue = hasher(key);
+    return IsAvalanching<H>::value ? hashValue : mixHash(hashValue);
+}
+
+// Smallest power of two that is at least n
+inline int roundUpPow2(int n) {
+    int size = 1;
+    while (size < n) {
+        size *= 2;
+    }
+    return size;
+}
+
+// Bucket array stored in fixed-size chunks, so a generation is built and
+// released a chunk at a time instead of as one multi-megabyte block whose
+// allocation or release stalls a single operation
+template<typename Bucket>
+class BucketArray {
+private:
+    static const size_t kChunkBits = 12;
+    static const size_t kChunkSize = size_t(1) << kChunkBits;
+    
+    vector<unique_ptr<Bucket[]>> chunks;
+    size_t count;
+    
+public:
+    BucketArray() : count(0) {}
+    
+    Bucket& operator[](size_t i) {
+        return chunks[i >> kChunkBits][i & (kChunkSize - 1)];
+    }
+    
+    size_t size() const {
+        return count;
+    }
+    
+    bool empty() const {
+        return count == 0;
+    }
+    
+    Bucket& back() {
+        return (*this)[count - 1];
+    }
+    
+    // Only bookkeeping for the chunk's pointer table; chunks are allocated
+    // as buckets are added
+    void reserve(size_t n) {
+        chunks.reserve((n + kChunkSize - 1) >> kChunkBits);
+    }
+    
+    void emplace_back() {
+        if ((count & (kChunkSize - 1)) == 0 && (count >> kChunkBits) == chunks.size()) {
+            chunks.emplace_back(new Bucket[kChunkSize]);
+        }
+        count++;
+    }
+    
+    // The last bucket must already be empty; its chunk is freed once no
+    // bucket in it is in use
+    void pop_back() {
+        count--;
+        if ((count & (kChunkSize - 1)) == 0) {
+            chunks.pop_back();
+        }
+    }
+    
+    void resize(size_t n) {
+        while (count > n) {
+            back().clear();
+            pop_back();
+        }
+        while (count < n) {
+            emplace_back();
+        }
+    }
+    
+    void swap(BucketArray& other) {
+        chunks.swap(other.chunks);
+        std::swap(count, other.count);
+    }
+};
+
+// Template Hash Table class (separate chaining engine)
+//
+// The table grows automatically once loadFactor() exceeds maxLoadFactor.
+// Growth is incremental: the previous bucket array stays live as the old
+// generation and a few of its buckets are spliced into the new one on every
+// operation, so no single call pays for a full rehash. The next bucket array
+// is likewise built a few buckets at a time ahead of the growth that needs it.
+//
+// The number of buckets is always a power of two, so a bucket is picked by
+// masking the hash instead of dividing by the table size.
+template<typename K, typename V, typename Engine = Chaining, typename Hasher = FastHash<K>>
 class HashTable {
 private:
-    // Hash table size (number of buckets)
-    int tableSize;
+    // Fewest old-generation buckets migrated per insert/remove/search
+    static const int kMigrateStep = 2;
+    
+    typedef BucketArray<list<pair<K, V>>> Buckets;
+    
+    // Hash table size (number of buckets, a power of two)
+    int tableSize;
+    
+    // Chunked array of lists to store key-value pairs
+    Buckets table;
+    
+    // Previous generation while a migration is in progress. Buckets are
+    // migrated from the back, so every old bucket still present is unmigrated.
+    Buckets oldTable;
+    
+    // Size of oldTable when its migration started (0 when not migrating)
+    int oldTableSize;
+    
+    // Bucket array for the next growth, constructed ahead of time
+    Buckets nextTable;
+    
+    // Scratch space for findBatch
+    vector<list<pair<K, V>>*> batchBuckets;
+    
+    // Number of stored key-value pairs across both generations
+    int itemCount;
+    
+    // Growth is triggered when itemCount exceeds tableSize * maxLoad
+    float maxLoad;
+    
+    // Number of migrations started, for diagnostics
+    int rehashCount;
+    
+    // bucketsOfSize[s] is the number of buckets (in either generation)
+    // holding exactly s > 0 pairs; it keeps maxBucketSize() O(1)
+    vector<int> bucketsOfSize;
+    
+    // Size of the largest bucket
+    int largestBucket;
+    
+    Hasher hasher;
+    
+    // Hash function
+    template<typename Q>
+    size_t hashFunction(const Q& key) {
+        return tableHash(hasher, key);
+    }
+    
+    // Record that a bucket just grew to newSize pairs
+    void bucketGrew(int newSize) {
+        if (newSize > 1) bucketsOfSize[newSize - 1]--;
+        if (newSize >= static_cast<int>(bucketsOfSize.size())) bucketsOfSize.resize(newSize + 1);
+        bucketsOfSize[newSize]++;
+        if (newSize > largestBucket) largestBucket = newSize;
+    }
+    
+    // Record that a bucket just shrank to newSize pairs
+    void bucketShrank(int newSize) {
+        bucketsOfSize[newSize + 1]--;
+        if (newSize > 0) bucketsOfSize[newSize]++;
+        while (largestBucket > 0 && bucketsOfSize[largestBucket] == 0) largestBucket--;
+    }
+    
+    // Find the bucket for a key, looking in the old generation if that
+    // bucket has not been migrated yet
+    template<typename Q>
+    list<pair<K, V>>& bucketFor(const Q& key) {
+        size_t hashValue = hashFunction(key);
+        if (oldTableSize > 0) {
+            size_t oldIndex = hashValue & (oldTableSize - 1);
+            if (oldIndex < oldTable.size()) {
+                return oldTable[oldIndex];
+            }
+        }
+        return table[hashValue & (tableSize - 1)];
+    }
+    
+    // Size of the bucket array the next growth will switch to
+    int grownSize() {
+        return tableSize * 2;
+    }
+    
+    // Enough buckets of the next generation per insert that it is complete
+    // by the time the load factor reaches the growth threshold
+    int prepareStep() {
+        return static_cast<int>(4 / maxLoad) + 2;
+    }
+    
+    // Old buckets to migrate per operation. Growth starts when itemCount
+    // passes tableSize * maxLoad, doubling the table, and the next one needs
+    // tableSize * maxLoad more inserts; migrating 1 / maxLoad buckets per
+    // insert drains the old generation before then, so a growth never has
+    // to finish the previous migration in one go.
+    int migrateStep() {
+        int step = static_cast<int>(1 / maxLoad) + 1;
+        return step > kMigrateStep ? step : kMigrateStep;
+    }
+    
+    // Construct up to `buckets` more buckets of the next generation
+    void prepare(int buckets) {
+        int target = grownSize();
+        nextTable.reserve(target);
+        while (buckets-- > 0 && static_cast<int>(nextTable.size()) < target) {
+            nextTable.emplace_back();
+        }
+    }
+    
+    // Move up to `buckets` old buckets into the new generation. Nodes are
+    // spliced, so migration never copies or allocates a key-value pair, and
+    // each chunk of the old array is freed as soon as it has drained.
+    void migrate(int buckets) {
+        while (buckets-- > 0 && oldTableSize > 0) {
+            auto& bucket = oldTable.back();
+            while (!bucket.empty()) {
+                auto& target = table[hashFunction(bucket.front().first) & (tableSize - 1)];
+                target.splice(target.end(), bucket, bucket.begin());
+                bucketShrank(bucket.size());
+                bucketGrew(target.size());
+            }
+            oldTable.pop_back();
+            
+            if (oldTable.empty()) {
+                oldTableSize = 0;
+            }
+        }
+    }
+    
+    // Start migrating into a fresh bucket array of newSize buckets (a power of two)
+    void beginMigration(int newSize) {
+        // At most two generations are live at once. Growth paces migration
+        // so this is a no-op for it; only an explicit resize or a lowered
+        // maxLoad can still find buckets left to move.
+        finishMigration();
+        
+        // Use the prepared array, completing or trimming it if needed
+        Buckets newTable;
+        nextTable.resize(newSize);
+        newTable.swap(nextTable);
+        
+        oldTable.swap(table);
+        oldTableSize = tableSize;
+        table.swap(newTable);
+        tableSize = newSize;
+        rehashCount++;
+    }
+    
+    void finishMigration() {
+        migrate(oldTableSize);
+    }
+    
+    // Add a pair to its bucket or update the existing value;
+    // returns true if the key was new
+    bool place(list<pair<K, V>>& bucket, const K& key, const V& value) {
+        // Check if key already exists
+        for (auto& kv : bucket) {
+            if (kv.first == key) {
+                // Update value if key exists
+                kv.second = value;
+                return false;
+            }
+        }
+        
+        // Add new key-value pair to the bucket
+        bucket.push_back(make_pair(key, value));
+        bucketGrew(bucket.size());
+        itemCount++;
+        return true;
+    }
+    
+    template<typename Q>
+    V* findValue(const Q& key) {
+        migrate(migrateStep());
+        
+        // Iterate through the bucket for this key
+        for (auto& kv : bucketFor(key)) {
+            if (kv.first == key) {
+                return &kv.second;
+            }
+        }
+        return nullptr;
+    }
+    
+public:
+    // Constructor; size is rounded up to a power of two
+    HashTable(int size = 10, float maxLoadFactor = 1.0f)
+        : tableSize(roundUpPow2(size)), oldTableSize(0), itemCount(0), maxLoad(maxLoadFactor), rehashCount(0),
+          bucketsOfSize(2), largestBucket(0) {
+        table.resize(tableSize);
+    }
+    
+    // Insert a key-value pair
+    void insert(const K& key, const V& value) {
+        migrate(migrateStep());
+        
+        // Find the bucket for this key
+        if (!place(bucketFor(key), key, value)) {
+            return;
+        }
+        prepare(prepareStep());
+        
+        // Grow once the load factor crosses the threshold; the work is
+        // spread over the following operations
+        if (itemCount > tableSize * maxLoad) {
+            prepare(grownSize());
+            beginMigration(grownSize());
+        }
+    }
+    
+    // Remove a key-value pair
+    bool remove(const K& key) {
+        migrate(migrateStep());
+        
+        // Find the bucket for this key
+        auto& bucket = bucketFor(key);
+        
+        // Iterate through the bucket
+        for (auto it = bucket.begin(); it != bucket.end(); ++it) {
+            if (it->first == key) {
+                // Remove key-value pair if found
+                bucket.erase(it);
+                bucketShrank(bucket.size());
+                itemCount--;
+                return true;
+            }
+        }
+        
+        // Key not found
+        return false;
+    }
+    
+    // Find a key and return a pointer to its value, or nullptr if absent.
+    // The pointer stays valid until the key is removed.
+    V* find(const K& key) {
+        return findValue(key);
+    }
+    
+    // Find with a key of another type that hashes like K (string_view or
+    // const char* for string keys), without constructing a K
+    template<typename Q, typename H = Hasher, typename H::is_transparent* = nullptr>
+    V* find(const Q& key) {
+        return findValue(key);
+    }
+    
+    // Search for a key and return its value
+    bool search(const K& key, V& value) {
+        V* found = findValue(key);
+        if (found == nullptr) {
+            // Key not found
+            return false;
+        }
+        
+        // Key found, return the value
+        value = *found;
+        return true;
+    }
+    
+    // Check whether a key is present
+    bool contains(const K& key) {
+        return findValue(key) != nullptr;
+    }
+    
+    template<typename Q, typename H = Hasher, typename H::is_transparent* = nullptr>
+    bool contains(const Q& key) {
+        return findValue(key) != nullptr;
+    }
+    
+    // Number of stored key-value pairs
+    int size() {
+        return itemCount;
+    }
+    
+    // Insert a range of key-value pairs. The table is sized for the final
+    // count first, so every pair is placed in a single pass with no growth.
+    template<typename Range>
+    void bulkInsert(const Range& pairs) {
+        int incoming = static_cast<int>(distance(begin(pairs), end(pairs)));
+        int needed = static_cast<int>((itemCount + incoming) / maxLoad) + 1;
+        if (needed > tableSize) {
+            resize(needed);
+        } else {
+            finishMigration();
+        }
+        
+        for (const auto& kv : pairs) {
+            place(table[hashFunction(kv.first) & (tableSize - 1)], kv.first, kv.second);
+        }
+    }
+    
+    // Look up a batch of keys, storing a pointer to each value (or nullptr)
+    // in out; returns the number found. Every key is hashed and its bucket
+    // prefetched before any bucket is probed, so the misses overlap.
+    template<typename KeyRange>
+    int findBatch(const KeyRange& keys, vector<V*>& out) {
+        migrate(migrateStep());
+        
+        size_t count = distance(begin(keys), end(keys));
+        out.resize(count);
+        batchBuckets.resize(count);
+        
+        size_t i = 0;
+        for (const auto& key : keys) {
+            batchBuckets[i] = &bucketFor(key);
+            __builtin_prefetch(batchBuckets[i]);
+            i++;
+        }
+        
+        // Bucket headers are arriving; prefetch the first node of each chain
+        for (auto* bucket : batchBuckets) {
+            if (!bucket->empty()) {
+                __builtin_prefetch(&bucket->front());
+            }
+        }
+        
+        int hits = 0;
+        i = 0;
+        for (const auto& key : keys) {
+            out[i] = nullptr;
+            for (auto& kv : *batchBuckets[i]) {
+                if (kv.first == key) {
+                    out[i] = &kv.second;
+                    hits++;
+                    break;
+                }
+            }
+            i++;
+        }
+        return hits;
+    }
+    
+    // Call visit(key, value) for every stored pair
+    template<typename F>
+    void forEach(F visit) {
+        for (size_t i = 0; i < table.size(); i++) {
+            for (const auto& kv : table[i]) {
+                visit(kv.first, kv.second);
+            }
+        }
+        for (size_t i = 0; i < oldTable.size(); i++) {
+            for (const auto& kv : oldTable[i]) {
+                visit(kv.first, kv.second);
+            }
+        }
+    }
+    
+    // Get all keys in the hash table
+    vector<K> getKeys() {
+        vector<K> keys;
+        
+        // Iterate through all buckets of both generations
+        forEach([&keys](const K& key, const V&) {
+            keys.push_back(key);
+        });
+        
+        return keys;
+    }
+    
+    // Get all values in the hash table
+    vector<V> getValues() {
+        vector<V> values;
+        
+        // Iterate through all buckets of both generations
+        forEach([&values](const K&, const V& value) {
+            values.push_back(value);
+        });
+        
+        return values;
+    }
+    
+    // Print the hash table
+    void display() {
+        for (int i = 0; i < tableSize; i++) {
+            cout << "Bucket " << i << ": ";
+            for (const auto& kv : table[i]) {
+                cout << "(" << kv.first << ", " << kv.second << ") ";
+            }
+            cout << endl;
+        }
+        
+        // Buckets of the old generation that are still waiting to migrate
+        for (int i = 0; i < static_cast<int>(oldTable.size()); i++) {
+            cout << "Old bucket " << i << ": ";
+            for (const auto& kv : oldTable[i]) {
+                cout << "(" << kv.first << ", " << kv.second << ") ";
+            }
+            cout << endl;
+        }
+    }
+    
+    // Get the current load factor
+    float loadFactor() {
+        return static_cast<float>(itemCount) / tableSize;
+    }
+    
+    // Set the load factor above which the table grows
+    void setMaxLoadFactor(float factor) {
+        maxLoad = factor;
+    }
+    
+    // True while an old generation is still being migrated
+    bool isRehashing() {
+        return oldTableSize > 0;
+    }
+    
+    // Number of growth or resize migrations started so far
+    int getRehashCount() {
+        return rehashCount;
+    }
+    
+    // Get the size of the largest bucket
+    int maxBucketSize() {
+        return largestBucket;
+    }
+    
+    // Resize the hash table to at least newSize buckets
+    void resize(int newSize) {
+        // Splice every node into the new bucket array right away
+        beginMigration(roundUpPow2(newSize));
+        finishMigration();
+    }
+};
+
+// Control bytes for the SwissTable engine. A full slot stores the low 7 bits
+// of its hash (0..127), so a set high bit means the slot is empty or deleted.
+namespace swiss {
+
+const int8_t kEmpty = -128;   // 0b10000000
+const int8_t kDeleted = -2;   // 0b11111110
+
+// A group of control bytes that is matched against a hash fragment at once.
+// Each match returns a bitmask with bit i set when byte i qualifies.
+struct Group {
+#if defined(__AVX2__)
+    static const size_t kWidth = 32;
+    __m256i ctrl;
+
+    explicit Group(const int8_t* pos)
+        : ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos))) {}
+
+    uint32_t match(int8_t h2) const {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(ctrl, _mm256_set1_epi8(h2))));
+    }
+
+    uint32_t matchEmpty() const {
+        return match(kEmpty);
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        return static_cast<uint32_t>(_mm256_movemask_epi8(ctrl));
+    }
+#elif defined(__SSE2__)
+    static const size_t kWidth = 16;
+    __m128i ctrl;
+
+    explicit Group(const int8_t* pos)
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+    uint32_t match(int8_t h2) const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+    }
+
+    uint32_t matchEmpty() const {
+        return match(kEmpty);
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+    }
+#else
+    static const size_t kWidth = 16;
+    const int8_t* ctrl;
+
+    explicit Group(const int8_t* pos) : ctrl(pos) {}
+
+    uint32_t match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kWidth; i++) {
+            if (ctrl[i] == h2) mask |= 1u << i;
+        }
+        return mask;
+    }
+
+    uint32_t matchEmpty() const {
+        return match(kEmpty);
+    }
+
+    uint32_t matchEmptyOrDeleted() const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < kWidth; i++) {
+            if (ctrl[i] < 0) mask |= 1u << i;
+        }
+        return mask;
+    }
+#endif
+};
+
+// Index of the lowest set bit of a non-empty match mask
+inline size_t lowestBit(uint32_t mask) {
+    return static_cast<size_t>(__builtin_ctz(mask));
+}
+
+} // namespace swiss
+
+// Hash Table with the SwissTable engine: keys and values live inline in one
+// flat slot array, and a parallel array of control bytes is probed a whole
+// group at a time, so most lookups touch one control group and one slot.
+template<typename K, typename V, typename Hasher>
+class HashTable<K, V, SwissTable, Hasher> {
+private:
+    typedef pair<K, V> Slot;
+    static const size_t kWidth = swiss::Group::kWidth;
+
+    // Number of slots; always a power of two and a multiple of kWidth
+    size_t capacity;
+
+    // Number of full slots
+    size_t itemCount;
+
+    // Inserts allowed into empty slots before the table must grow
+    size_t growthLeft;
+    
+    // Longest probe sequence (in groups) of any insert since the last rehash.
+    // Removals do not lower it, so it is an upper bound between rehashes.
+    int maxProbe;
+
+    // One control byte per slot
+    vector<int8_t> ctrl;
+
+    // Uninitialized slot storage; only slots with a full control byte are constructed
+    Slot* slots;
+
+    allocator<Slot> alloc;
+
+    // Scratch space for findBatch
+    vector<size_t> batchHashes;
+
+    Hasher hasher;
+
+    // Hash function; both the group index and the 7-bit tag need well spread bits
+    template<typename Q>
+    size_t hashFunction(const Q& key) const {
+        return tableHash(hasher, key);
+    }
+
+    static int8_t h2(size_t hashValue) {
+        return static_cast<int8_t>(hashValue & 0x7F);
+    }
+
+    size_t groupMask() const {
+        return capacity / kWidth - 1;
+    }
+
+    // Maximum number of full and deleted slots (7/8 of capacity)
+    static size_t maxLoad(size_t cap) {
+        return cap - cap / 8;
+    }
+
+    // Smallest valid capacity that keeps n elements under the maximum load
+    static size_t capacityFor(size_t n) {
+        size_t cap = kWidth;
+        while (maxLoad(cap) < n) {
+            cap *= 2;
+        }
+        return cap;
+    }
+
+    // Find the slot holding key, or capacity if it is absent
+    template<typename Q>
+    size_t findSlot(const Q& key) const {
+        return findSlot(key, hashFunction(key));
+    }
+
+    template<typename Q>
+    size_t findSlot(const Q& key, size_t hashValue) const {
+        size_t group = (hashValue >> 7) & groupMask();
+        for (size_t step = 1; ; step++) {
+            swiss::Group g(&ctrl[group * kWidth]);
+            for (uint32_t mask = g.match(h2(hashValue)); mask != 0; mask &= mask - 1) {
+                size_t index = group * kWidth + swiss::lowestBit(mask);
+                if (slots[index].first == key) {
+                    return index;
+                }
+            }
+            // A probe sequence ends at the first group with an empty slot
+            if (g.matchEmpty() != 0) {
+                return capacity;
+            }
+            group = (group + step) & groupMask();
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of hashValue;
+    // also raises maxProbe to the number of groups visited
+    size_t findInsertSlot(size_t hashValue) {
+        size_t group = (hashValue >> 7) & groupMask();
+        for (size_t step = 1; ; step++) {
+            uint32_t mask = swiss::Group(&ctrl[group * kWidth]).matchEmptyOrDeleted();
+            if (mask != 0) {
+                if (static_cast<int>(step) > maxProbe) {
+                    maxProbe = static_cast<int>(step);
+                }
+                return group * kWidth + swiss::lowestBit(mask);
+            }
+            group = (group + step) & groupMask();
+        }
+    }
+
+    // Rebuild the table with newCapacity slots, dropping all tombstones
+    void rehash(size_t newCapacity) {
+        vector<int8_t> oldCtrl(newCapacity, swiss::kEmpty);
+        oldCtrl.swap(ctrl);
+        Slot* oldSlots = slots;
+        size_t oldCapacity = capacity;
+
+        capacity = newCapacity;
+        slots = alloc.allocate(capacity);
+        growthLeft = maxLoad(capacity) - itemCount;
+        maxProbe = 0;
+
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldCtrl[i] >= 0) {
+                size_t hashValue = hashFunction(oldSlots[i].first);
+                size_t index = findInsertSlot(hashValue);
+                ctrl[index] = h2(hashValue);
+                new (&slots[index]) Slot(std::move(oldSlots[i]));
+                oldSlots[i].~Slot();
+            }
+        }
+
+        if (oldSlots != nullptr) {
+            alloc.deallocate(oldSlots, oldCapacity);
+        }
+    }
+
+    // Make room for one more insert into an empty slot
+    void grow() {
+        // Mostly tombstones: rehashing in place is enough to reclaim them
+        if (itemCount < maxLoad(capacity) / 2) {
+            rehash(capacity);
+        } else {
+            rehash(capacity * 2);
+        }
+    }
+
+    void destroyAll() {
+        if (slots == nullptr) return;
+        for (size_t i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                slots[i].~Slot();
+            }
+        }
+        alloc.deallocate(slots, capacity);
+        slots = nullptr;
+    }
+
+public:
+    // Constructor
+    HashTable(int size = 10)
+        : capacity(capacityFor(size > 0 ? static_cast<size_t>(size) : 0)), itemCount(0),
+          growthLeft(maxLoad(capacity)), maxProbe(0), ctrl(capacity, swiss::kEmpty), slots(alloc.allocate(capacity)) {}
+
+    HashTable(const HashTable& other)
+        : capacity(other.capacity), itemCount(0), growthLeft(maxLoad(capacity)), maxProbe(0),
+          ctrl(capacity, swiss::kEmpty), slots(alloc.allocate(capacity)) {
+        for (size_t i = 0; i < other.capacity; i++) {
+            if (other.ctrl[i] >= 0) {
+                insert(other.slots[i].first, other.slots[i].second);
+            }
+        }
+    }
+
+    HashTable& operator=(HashTable other) {
+        swap(capacity, other.capacity);
+        swap(itemCount, other.itemCount);
+        swap(growthLeft, other.growthLeft);
+        swap(maxProbe, other.maxProbe);
+        ctrl.swap(other.ctrl);
+        swap(slots, other.slots);
+        return *this;
+    }
+
+    ~HashTable() {
+        destroyAll();
+    }
+
+    // Insert a key-value pair
+    void insert(const K& key, const V& value) {
+        size_t index = findSlot(key);
+        if (index != capacity) {
+            // Update value if key exists
+            slots[index].second = value;
+            return;
+        }
+
+        size_t hashValue = hashFunction(key);
+        index = findInsertSlot(hashValue);
+
+        // Reusing a tombstone never lengthens a probe sequence, filling an empty slot may
+        if (ctrl[index] == swiss::kEmpty && growthLeft == 0) {
+            grow();
+            index = findInsertSlot(hashValue);
+        }
+        if (ctrl[index] == swiss::kEmpty) {
+            growthLeft--;
+        }
+
+        ctrl[index] = h2(hashValue);
+        new (&slots[index]) Slot(key, value);
+        itemCount++;
+    }
+
+    // Remove a key-value pair
+    bool remove(const K& key) {
+        size_t index = findSlot(key);
+        if (index == capacity) {
+            // Key not found
+            return false;
+        }
+
+        slots[index].~Slot();
+        itemCount--;
+
+        // No probe sequence continues past a group that still has an empty
+        // slot, so the slot can become empty again instead of a tombstone
+        size_t groupStart = index - index % kWidth;
+        if (swiss::Group(&ctrl[groupStart]).matchEmpty() != 0) {
+            ctrl[index] = swiss::kEmpty;
+            growthLeft++;
+        } else {
+            ctrl[index] = swiss::kDeleted;
+        }
+        return true;
+    }
+
+    // Find a key and return a pointer to its value, or nullptr if absent.
+    // The pointer is invalidated by the next insert, which may rehash.
+    V* find(const K& key) {
+        size_t index = findSlot(key);
+        return index == capacity ? nullptr : &slots[index].second;
+    }
+
+    // Find with a key of another type that hashes like K (string_view or
+    // const char* for string keys), without constructing a K
+    template<typename Q, typename H = Hasher, typename H::is_transparent* = nullptr>
+    V* find(const Q& key) {
+        size_t index = findSlot(key);
+        return index == capacity ? nullptr : &slots[index].second;
+    }
+
+    // Search for a key and return its value
+    bool search(const K& key, V& value) {
+        size_t index = findSlot(key);
+        if (index == capacity) {
+            // Key not found
+            return false;
+        }
+
+        value = slots[index].second;
+        return true;
+    }
+
+    // Check whether a key is present
+    bool contains(const K& key) {
+        return findSlot(key) != capacity;
+    }
+
+    template<typename Q, typename H = Hasher, typename H::is_transparent* = nullptr>
+    bool contains(const Q& key) {
+        return findSlot(key) != capacity;
+    }
+
+    // Number of stored key-value pairs
+    int size() {
+        return static_cast<int>(itemCount);
+    }
+
+    // Insert a range of key-value pairs. The table is sized for the final
+    // count first, so every pair is placed in a single pass with no growth.
+    template<typename Range>
+    void bulkInsert(const Range& pairs) {
+        size_t incoming = distance(begin(pairs), end(pairs));
+        size_t needed = capacityFor(itemCount + incoming);
+        if (needed > capacity) {
+            rehash(needed);
+        }
+
+        for (const auto& kv : pairs) {
+            insert(kv.first, kv.second);
+        }
+    }
+
+    // Look up a batch of keys, storing a pointer to each value (or nullptr)
+    // in out; returns the number found. Every key is hashed and its control
+    // group prefetched before any group is probed, so the misses overlap.
+    template<typename KeyRange>
+    int findBatch(const KeyRange& keys, vector<V*>& out) {
+        size_t count = distance(begin(keys), end(keys));
+        out.resize(count);
+        batchHashes.resize(count);
+
+        size_t i = 0;
+        for (const auto& key : keys) {
+            batchHashes[i] = hashFunction(key);
+            __builtin_prefetch(&ctrl[((batchHashes[i] >> 7) & groupMask()) * kWidth]);
+            i++;
+        }
+
+        // Control groups are arriving; prefetch the first candidate slot of each
+        for (size_t hashValue : batchHashes) {
+            size_t group = (hashValue >> 7) & groupMask();
+            uint32_t mask = swiss::Group(&ctrl[group * kWidth]).match(h2(hashValue));
+            if (mask != 0) {
+                __builtin_prefetch(&slots[group * kWidth + swiss::lowestBit(mask)]);
+            }
+        }
+
+        int hits = 0;
+        i = 0;
+        for (const auto& key : keys) {
+            size_t index = findSlot(key, batchHashes[i]);
+            out[i] = index == capacity ? nullptr : &slots[index].second;
+            if (out[i] != nullptr) hits++;
+            i++;
+        }
+        return hits;
+    }
+
+    // Call visit(key, value) for every stored pair
+    template<typename F>
+    void forEach(F visit) {
+        for (size_t i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                visit(slots[i].first, slots[i].second);
+            }
+        }
+    }
+
+    // Get all keys in the hash table
+    vector<K> getKeys() {
+        vector<K> keys;
+        keys.reserve(itemCount);
+        for (size_t i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                keys.push_back(slots[i].first);
+            }
+        }
+        return keys;
+    }
+
+    // Get all values in the hash table
+    vector<V> getValues() {
+        vector<V> values;
+        values.reserve(itemCount);
+        for (size_t i = 0; i < capacity; i++) {
+            if (ctrl[i] >= 0) {
+                values.push_back(slots[i].second);
+            }
+        }
+        return values;
+    }
+
+    // Print the hash table, one control group per line
+    void display() {
+        for (size_t group = 0; group * kWidth < capacity; group++) {
+            cout << "Group " << group << ": ";
+            for (size_t i = group * kWidth; i < (group + 1) * kWidth; i++) {
+                if (ctrl[i] >= 0) {
+                    cout << "(" << slots[i].first << ", " << slots[i].second << ") ";
+                }
+            }
+            cout << endl;
+        }
+    }
+
+    // Get the current load factor
+    float loadFactor() {
+        return static_cast<float>(itemCount) / capacity;
+    }
+
+    // Get the length of the longest probe sequence, in groups
+    int maxBucketSize() {
+        return maxProbe;
+    }
+
+    // Resize the hash table to at least newSize slots
+    void resize(int newSize) {
+        size_t wanted = capacityFor(itemCount);
+        while (wanted < static_cast<size_t>(newSize > 0 ? newSize : 0)) {
+            wanted *= 2;
+        }
+        rehash(wanted);
+    }
+};
+
+// Concurrent Hash Table: keys are spread over independently locked shards.
+// Epoch-based reclamation, the same scheme as skiplist.cpp: a retired shard
+// array is freed only after the global epoch has advanced twice, by which
+// point no optimistic reader can still be probing it.
+class EpochDomain {
+public:
+    static const int MAX_THREADS = 256;
+    
+private:
+    static const uint64_t INACTIVE = ~0ull;
+    static const size_t SCAN_THRESHOLD = 64;
+    
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+    
+    struct alignas(64) ThreadRecord {
+        atomic<uint64_t> epoch;
+        atomic<bool> inUse;
+        int nesting;
+        vector<Retired> limbo;
+        
+        ThreadRecord() : epoch(INACTIVE), inUse(false), nesting(0) {}
+    };
+    
+    atomic<uint64_t> globalEpoch;
+    ThreadRecord records[MAX_THREADS];
+    
+    mutex orphanLock;
+    vector<Retired> orphans;
+    
+    
+    struct Registration {
+        ThreadRecord* record = nullptr;
+        
+        ~Registration() {
+            if (record != nullptr) {
+                EpochDomain::instance().release(record);
+            }
+        }
+    };
+    
+    EpochDomain() : globalEpoch(1) {}
+    
+    // Runs at exit, after every thread has left; nothing can be read any more
+    ~EpochDomain() {
+        freeExpired(orphans, INACTIVE);
+        for (int i = 0; i < MAX_THREADS; i++) {
+            freeExpired(records[i].limbo, INACTIVE);
+        }
+    }
+    
+    ThreadRecord& local() {
+        static thread_local Registration registration;
+        if (registration.record == nullptr) {
+            for (int i = 0; ; i = (i + 1) % MAX_THREADS) {
+                bool expected = false;
+                if (!records[i].inUse.load(memory_order_relaxed) &&
+                    records[i].inUse.compare_exchange_strong(expected, true, memory_order_acquire)) {
+                    registration.record = &records[i];
+                    break;
+                }
+            }
+        }
+        return *registration.record;
+    }
+    
+    void release(ThreadRecord* record) {
+        if (!record->limbo.empty()) {
+            lock_guard<mutex> guard(orphanLock);
+            orphans.insert(orphans.end(), record->limbo.begin(), record->limbo.end());
+            record->limbo.clear();
+        }
+        record->inUse.store(false, memory_order_release);
+    }
+    
+    
+    bool tryAdvance() {
+        uint64_t current = globalEpoch.load(memory_order_seq_cst);
+        for (int i = 0; i < MAX_THREADS; i++) {
+            uint64_t e = records[i].epoch.load(memory_order_seq_cst);
+            if (e != INACTIVE && e != current) {
+                return false;
+            }
+        }
+        globalEpoch.compare_exchange_strong(current, current + 1, memory_order_seq_cst);
+        return true;
+    }
+    
+    
+    static void freeExpired(vector<Retired>& list, uint64_t now) {
+        size_t kept = 0;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (list[i].epoch + 2 <= now) {
+                list[i].deleter(list[i].ptr);
+            } else {
+                list[kept++] = list[i];
+            }
+        }
+        list.resize(kept);
+    }
+    
+public:
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+    
+    void enter() {
+        ThreadRecord& record = local();
+        if (record.nesting++ == 0) {
+            record.epoch.store(globalEpoch.load(memory_order_relaxed), memory_order_seq_cst);
+        }
+    }
+    
+    void exit() {
+        ThreadRecord& record = local();
+        if (--record.nesting == 0) {
+            record.epoch.store(INACTIVE, memory_order_release);
+        }
+    }
+    
+    // Free ptr once every thread that might still see it has left its critical section
+    void retire(void* ptr, void (*deleter)(void*)) {
+        ThreadRecord& record = local();
+        record.limbo.push_back(Retired{ptr, deleter, globalEpoch.load(memory_order_relaxed)});
+        
+        if (record.limbo.size() >= SCAN_THRESHOLD) {
+            tryAdvance();
+            uint64_t now = globalEpoch.load(memory_order_relaxed);
+            freeExpired(record.limbo, now);
+            
+            unique_lock<mutex> guard(orphanLock, try_to_lock);
+            if (guard.owns_lock() && !orphans.empty()) {
+                freeExpired(orphans, now);
+            }
+        }
+    }
+};
+
+class EpochGuard {
+public:
+    EpochGuard() {
+        EpochDomain::instance().enter();
+    }
+    
+    ~EpochGuard() {
+        EpochDomain::instance().exit();
+    }
+    
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+// Writers lock only their own shard, so writers on different shards never
+// contend. Each shard is a flat linear-probing array guarded by a seqlock
+// style version counter that is odd while a writer is mutating it. When both
+// K and V are trivially copyable, readers take no lock: they copy slots out,
+// then retry if the version moved. Other types fall back to a shared lock.
+template<typename K, typename V, typename Hasher = FastHash<K>>
+class ConcurrentHashTable {
+private:
+    static const bool kOptimisticReads = is_trivially_copyable<K>::value && is_trivially_copyable<V>::value;
     
-    // Vector of lists to store key-value pairs
-    vector<list<pair<K, V>>> table;
+    enum SlotState : uint8_t { EMPTY = 0, FULL = 1, DELETED = 2 };
     
-    // Hash function
-    int hashFunction(const K& key) {
-        // Use the standard hash function
-        size_t hashValue = hash<K>{}(key);
-        return hashValue % tableSize;
+    struct Slot {
+        SlotState state;
+        K key;
+        V value;
+        
+        Slot() : state(EMPTY), key(), value() {}
+    };
+    
+    struct Array {
+        size_t mask;
+        vector<Slot> slots;
+        
+        explicit Array(size_t capacity) : mask(capacity - 1), slots(capacity) {}
+    };
+    
+    // Each shard sits on its own cache lines so writers do not false-share
+    struct alignas(64) Shard {
+        shared_mutex lock;
+        atomic<uint64_t> version;
+        atomic<Array*> array;
+        size_t itemCount;
+        size_t usedCount;   // full plus deleted slots
+        
+        Shard() : version(0), array(nullptr), itemCount(0), usedCount(0) {}
+    };
+    
+    vector<Shard> shards;
+    size_t shardMask;
+    
+    Hasher hasher;
+    
+    size_t hashFunction(const K& key) const {
+        return tableHash(hasher, key);
+    }
+    
+    // High hash bits pick the shard, low bits the slot inside it
+    Shard& shardFor(size_t hashValue) {
+        return shards[(hashValue >> 48) & shardMask];
+    }
+    
+    // Writers bracket every mutation with these so readers can detect it
+    static void beginWrite(Shard& shard) {
+        shard.version.store(shard.version.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+    }
+    
+    static void endWrite(Shard& shard) {
+        shard.version.store(shard.version.load(memory_order_relaxed) + 1, memory_order_release);
+    }
+    
+    // Slot holding key in arr, or the insert position (first deleted or empty
+    // slot on the probe sequence) when the key is absent. Caller holds the lock.
+    static size_t probe(const Array& arr, const K& key, size_t hashValue, bool& found) {
+        size_t index = hashValue & arr.mask;
+        size_t insertAt = arr.slots.size();
+        while (true) {
+            const Slot& slot = arr.slots[index];
+            if (slot.state == EMPTY) {
+                found = false;
+                return insertAt != arr.slots.size() ? insertAt : index;
+            }
+            if (slot.state == FULL && slot.key == key) {
+                found = true;
+                return index;
+            }
+            if (slot.state == DELETED && insertAt == arr.slots.size()) {
+                insertAt = index;
+            }
+            index = (index + 1) & arr.mask;
+        }
+    }
+    
+    static void destroyArray(void* arr) {
+        delete static_cast<Array*>(arr);
+    }
+    
+    // Rebuild the shard's array; caller holds the lock inside a write section.
+    // Optimistic readers may still be probing the old array, so it goes to
+    // the epoch domain rather than straight to delete.
+    void rehash(Shard& shard, size_t newCapacity) {
+        Array* oldArray = shard.array.load(memory_order_relaxed);
+        Array* newArray = new Array(newCapacity);
+        
+        for (Slot& slot : oldArray->slots) {
+            if (slot.state != FULL) continue;
+            size_t index = hashFunction(slot.key) & newArray->mask;
+            while (newArray->slots[index].state != EMPTY) {
+                index = (index + 1) & newArray->mask;
+            }
+            newArray->slots[index].state = FULL;
+            newArray->slots[index].key = slot.key;
+            newArray->slots[index].value = slot.value;
+        }
+        
+        shard.array.store(newArray, memory_order_release);
+        EpochDomain::instance().retire(oldArray, &ConcurrentHashTable::destroyArray);
+        shard.usedCount = shard.itemCount;
+    }
+    
+    bool searchOptimistic(Shard& shard, const K& key, size_t hashValue, V& value) {
+        alignas(Slot) unsigned char buffer[sizeof(Slot)];
+        const Slot* copy = reinterpret_cast<const Slot*>(buffer);
+        // Keeps the array loaded below alive until the probe is done
+        EpochGuard guard;
+        
+        while (true) {
+            uint64_t before = shard.version.load(memory_order_acquire);
+            if (before & 1) {
+                // A writer is inside the shard
+                this_thread::yield();
+                continue;
+            }
+            
+            const Array* arr = shard.array.load(memory_order_acquire);
+            bool found = false;
+            V result{};
+            size_t index = hashValue & arr->mask;
+            
+            // Bounded by the capacity, since a torn read may show no empty slot
+            for (size_t n = 0; n <= arr->mask; n++) {
+                memcpy(buffer, &arr->slots[index], sizeof(Slot));
+                if (copy->state == EMPTY) break;
+                if (copy->state == FULL && copy->key == key) {
+                    found = true;
+                    result = copy->value;
+                    break;
+                }
+                index = (index + 1) & arr->mask;
+            }
+            
+            atomic_thread_fence(memory_order_acquire);
+            if (shard.version.load(memory_order_relaxed) == before) {
+                if (found) value = result;
+                return found;
+            }
+        }
     }
     
 public:
-    // Constructor
-    HashTable(int size = 10) : tableSize(size) {
-        table.resize(tableSize);
+    // Constructor; shardCount is rounded up to a power of two
+    ConcurrentHashTable(int shardCount = 64, int size = 1024) {
+        size_t count = 1;
+        while (count < static_cast<size_t>(shardCount)) count *= 2;
+        
+        size_t perShard = 8;
+        while (perShard * count < static_cast<size_t>(size)) perShard *= 2;
+        
+        shards = vector<Shard>(count);
+        shardMask = count - 1;
+        for (Shard& shard : shards) {
+            shard.array.store(new Array(perShard), memory_order_relaxed);
+        }
+    }
+    
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+    
+    ~ConcurrentHashTable() {
+        for (Shard& shard : shards) {
+            delete shard.array.load(memory_order_relaxed);
+        }
     }
     
     // Insert a key-value pair
     void insert(const K& key, const V& value) {
-        // Find the bucket for this key
-        int index = hashFunction(key);
+        size_t hashValue = hashFunction(key);
+        Shard& shard = shardFor(hashValue);
+        unique_lock<shared_mutex> guard(shard.lock);
+        beginWrite(shard);
         
-        // Check if key already exists
-        for (auto& kv : table[index]) {
-            if (kv.first == key) {
-                // Update value if key exists
-                kv.second = value;
-                return;
-            }
+        Array* arr = shard.array.load(memory_order_relaxed);
+        bool found;
+        size_t index = probe(*arr, key, hashValue, found);
+        if (found) {
+            // Update value if key exists
+            arr->slots[index].value = value;
+            endWrite(shard);
+            return;
         }
         
-        // Add new key-value pair to the bucket
-        table[index].push_back(make_pair(key, value));
+        // Keep at least a quarter of the slots empty so probes stay short
+        if (arr->slots[index].state == EMPTY && (shard.usedCount + 1) * 4 > arr->slots.size() * 3) {
+            rehash(shard, shard.itemCount * 2 >= arr->slots.size() ? arr->slots.size() * 2 : arr->slots.size());
+            arr = shard.array.load(memory_order_relaxed);
+            index = probe(*arr, key, hashValue, found);
+        }
+        
+        Slot& slot = arr->slots[index];
+        if (slot.state == EMPTY) {
+            shard.usedCount++;
+        }
+        slot.key = key;
+        slot.value = value;
+        slot.state = FULL;
+        shard.itemCount++;
+        endWrite(shard);
     }
     
     // Remove a key-value pair
     bool remove(const K& key) {
-        // Find the bucket for this key
-        int index = hashFunction(key);
+        size_t hashValue = hashFunction(key);
+        Shard& shard = shardFor(hashValue);
+        unique_lock<shared_mutex> guard(shard.lock);
         
-        // Iterate through the bucket
-        for (auto it = table[index].begin(); it != table[index].end(); ++it) {
-            if (it->first == key) {
-                // Remove key-value pair if found
-                table[index].erase(it);
-                return true;
-            }
+        Array* arr = shard.array.load(memory_order_relaxed);
+        bool found;
+        size_t index = probe(*arr, key, hashValue, found);
+        if (!found) {
+            // Key not found
+            return false;
         }
         
-        // Key not found
-        return false;
+        beginWrite(shard);
+        arr->slots[index].state = DELETED;
+        shard.itemCount--;
+        endWrite(shard);
+        return true;
     }
     
     // Search for a key and return its value
     bool search(const K& key, V& value) {
-        // Find the bucket for this key
-        int index = hashFunction(key);
-        
-        // Iterate through the bucket
-        for (const auto& kv : table[index]) {
-            if (kv.first == key) {
-                // Key found, return the value
-                value = kv.second;
-                return true;
-            }
+        size_t hashValue = hashFunction(key);
+        Shard& shard = shardFor(hashValue);
+        if (kOptimisticReads) {
+            return searchOptimistic(shard, key, hashValue, value);
         }
         
-        // Key not found
+        shared_lock<shared_mutex> guard(shard.lock);
+        const Array* arr = shard.array.load(memory_order_relaxed);
+        bool found;
+        size_t index = probe(*arr, key, hashValue, found);
+        if (found) {
+            value = arr->slots[index].value;
+        }
+        return found;
+    }
+    
+    // Number of stored key-value pairs; exact only when no writer is active
+    size_t size() {
+        size_t total = 0;
+        for (Shard& shard : shards) {
+            shared_lock<shared_mutex> guard(shard.lock);
+            total += shard.itemCount;
+        }
+        return total;
+    }
+    
+    int shardCount() {
+        return static_cast<int>(shards.size());
+    }
+};
+
+// On-disk snapshot of a HashTable<string, V> that is queried in place through
+// mmap. Every reference inside the file is an offset from the start of the
+// file, so the mapping can land at any address and nothing is deserialized;
+// pages are read from disk only when a lookup touches them.
+//
+// Layout: header | slot array | value array | key bytes. The slot array is a
+// power-of-two linear-probing table at most half full. Keys are hashed with
+// snapshotHash, which unlike std::hash is the same in every build.
+namespace snapshot {
+
+const char kMagic[8] = {'H', 'T', 'S', 'N', 'A', 'P', '0', '1'};
+const uint32_t kVersion = 1;
+const uint32_t kEmptySlot = 0xFFFFFFFFu;   // keyLength of an unused slot
+const uint64_t kAlign = 64;
+
+struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t valueSize;
+    uint64_t slotCount;
+    uint64_t itemCount;
+    uint64_t slotsOffset;
+    uint64_t valuesOffset;
+    uint64_t keysOffset;
+    uint64_t fileSize;
+};
+
+struct Slot {
+    uint64_t hash;
+    uint64_t keyOffset;   // relative to keysOffset
+    uint32_t keyLength;
+    uint32_t reserved;
+};
+
+// FNV-1a followed by a final mix
+inline uint64_t snapshotHash(string_view key) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001B3ull;
+    }
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    return h ^ (h >> 33);
+}
+
+inline uint64_t alignUp(uint64_t offset) {
+    return (offset + kAlign - 1) / kAlign * kAlign;
+}
+
+} // namespace snapshot
+
+// Write a table to path in the snapshot layout; returns false on I/O error
+template<typename V, typename Engine, typename Hasher>
+bool writeSnapshot(HashTable<string, V, Engine, Hasher>& table, const string& path) {
+    static_assert(is_trivially_copyable<V>::value, "snapshot values are stored as raw bytes");
+    
+    uint64_t slotCount = 16;
+    while (slotCount < 2 * static_cast<uint64_t>(table.size())) {
+        slotCount *= 2;
+    }
+    
+    vector<snapshot::Slot> slots(slotCount, snapshot::Slot{0, 0, snapshot::kEmptySlot, 0});
+    vector<V> values(slotCount);
+    string keys;
+    table.forEach([&](const string& key, const V& value) {
+        uint64_t h = snapshot::snapshotHash(key);
+        uint64_t index = h & (slotCount - 1);
+        while (slots[index].keyLength != snapshot::kEmptySlot) {
+            index = (index + 1) & (slotCount - 1);
+        }
+        slots[index] = snapshot::Slot{h, keys.size(), static_cast<uint32_t>(key.size()), 0};
+        values[index] = value;
+        keys += key;
+    });
+    
+    snapshot::Header header;
+    memcpy(header.magic, snapshot::kMagic, sizeof(header.magic));
+    header.version = snapshot::kVersion;
+    header.valueSize = sizeof(V);
+    header.slotCount = slotCount;
+    header.itemCount = table.size();
+    header.slotsOffset = snapshot::alignUp(sizeof(header));
+    header.valuesOffset = snapshot::alignUp(header.slotsOffset + slotCount * sizeof(snapshot::Slot));
+    header.keysOffset = snapshot::alignUp(header.valuesOffset + slotCount * sizeof(V));
+    header.fileSize = header.keysOffset + keys.size();
+    
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
         return false;
     }
     
-    // Get all keys in the hash table
-    vector<K> getKeys() {
-        vector<K> keys;
+    // Write each section at its offset, zero-filling the alignment gaps
+    auto writeAt = [file](uint64_t offset, const void* data, size_t size) {
+        static const char zeros[snapshot::kAlign] = {};
+        long position = ftell(file);
+        while (position >= 0 && static_cast<uint64_t>(position) < offset) {
+            size_t gap = min<uint64_t>(sizeof(zeros), offset - position);
+            if (fwrite(zeros, 1, gap, file) != gap) return false;
+            position += gap;
+        }
+        return size == 0 || fwrite(data, 1, size, file) == size;
+    };
+    
+    bool ok = writeAt(0, &header, sizeof(header)) &&
+              writeAt(header.slotsOffset, slots.data(), slots.size() * sizeof(snapshot::Slot)) &&
+              writeAt(header.valuesOffset, values.data(), values.size() * sizeof(V)) &&
+              writeAt(header.keysOffset, keys.data(), keys.size());
+    return fclose(file) == 0 && ok;
+}
+
+// Read-only view of a snapshot file, queried directly in the mapping
+template<typename V>
+class MappedHashTable {
+private:
+    const char* base;
+    size_t mappedSize;
+    const snapshot::Header* header;
+    const snapshot::Slot* slots;
+    const V* values;
+    const char* keys;
+    uint64_t keysSize;
+    
+    void close() {
+        if (base != nullptr) {
+            munmap(const_cast<char*>(base), mappedSize);
+        }
+        base = nullptr;
+        mappedSize = 0;
+        header = nullptr;
+        keysSize = 0;
+    }
+    
+public:
+    MappedHashTable()
+        : base(nullptr), mappedSize(0), header(nullptr), slots(nullptr), values(nullptr), keys(nullptr), keysSize(0) {}
+    
+    MappedHashTable(const MappedHashTable&) = delete;
+    MappedHashTable& operator=(const MappedHashTable&) = delete;
+    
+    ~MappedHashTable() {
+        close();
+    }
+    
+    // Map a snapshot file; returns false if it is missing or not a valid
+    // snapshot for this value type. Only the header is read here, so slots
+    // are bounds-checked as find reaches them.
+    bool open(const string& path) {
+        close();
         
-        // Iterate through all buckets
-        for (int i = 0; i < tableSize; i++) {
-            for (const auto& kv : table[i]) {
-                keys.push_back(kv.first);
-            }
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(snapshot::Header)) {
+            ::close(fd);
+            return false;
         }
         
-        return keys;
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            return false;
+        }
+        base = static_cast<const char*>(mapping);
+        mappedSize = info.st_size;
+        
+        // Lookups hit random pages, so read-ahead would only add I/O
+        madvise(mapping, mappedSize, MADV_RANDOM);
+        
+        // Every size is checked against what is left of the mapping before
+        // it is multiplied or added, so a hostile header cannot wrap around
+        header = reinterpret_cast<const snapshot::Header*>(base);
+        uint64_t slotCount = header->slotCount;
+        bool valid = memcmp(header->magic, snapshot::kMagic, sizeof(header->magic)) == 0 &&
+                     header->version == snapshot::kVersion &&
+                     header->valueSize == sizeof(V) &&
+                     header->fileSize == mappedSize &&
+                     slotCount != 0 && (slotCount & (slotCount - 1)) == 0 &&
+                     header->itemCount < slotCount &&
+                     header->slotsOffset <= mappedSize &&
+                     slotCount <= (mappedSize - header->slotsOffset) / sizeof(snapshot::Slot) &&
+                     header->slotsOffset + slotCount * sizeof(snapshot::Slot) <= header->valuesOffset &&
+                     header->valuesOffset <= mappedSize &&
+                     slotCount <= (mappedSize - header->valuesOffset) / sizeof(V) &&
+                     header->valuesOffset + slotCount * sizeof(V) <= header->keysOffset &&
+                     header->keysOffset <= mappedSize;
+        if (!valid) {
+            close();
+            return false;
+        }
+        
+        slots = reinterpret_cast<const snapshot::Slot*>(base + header->slotsOffset);
+        values = reinterpret_cast<const V*>(base + header->valuesOffset);
+        keys = base + header->keysOffset;
+        keysSize = mappedSize - header->keysOffset;
+        return true;
     }
     
-    // Get all values in the hash table
-    vector<V> getValues() {
-        vector<V> values;
+    bool isOpen() const {
+        return header != nullptr;
+    }
+    
+    // Find a key and return a pointer to its value inside the mapping, or nullptr
+    const V* find(string_view key) const {
+        if (header == nullptr) {
+            return nullptr;
+        }
         
-        // Iterate through all buckets
-        for (int i = 0; i < tableSize; i++) {
-            for (const auto& kv : table[i]) {
-                values.push_back(kv.second);
+        uint64_t h = snapshot::snapshotHash(key);
+        uint64_t mask = header->slotCount - 1;
+        uint64_t index = h & mask;
+        // A corrupt file may have no empty slot, so probe each slot at most once
+        for (uint64_t probes = 0; probes < header->slotCount; probes++, index = (index + 1) & mask) {
+            const snapshot::Slot& slot = slots[index];
+            if (slot.keyLength == snapshot::kEmptySlot) {
+                return nullptr;
+            }
+            if (slot.hash == h && slot.keyLength == key.size() &&
+                slot.keyOffset <= keysSize && slot.keyLength <= keysSize - slot.keyOffset &&
+                memcmp(keys + slot.keyOffset, key.data(), key.size()) == 0) {
+                return &values[index];
             }
         }
-        
-        return values;
+        return nullptr;
     }
     
-    // Print the hash table
-    void display() {
-        for (int i = 0; i < tableSize; i++) {
-            cout << "Bucket " << i << ": ";
-            for (const auto& kv : table[i]) {
-                cout << "(" << kv.first << ", " << kv.second << ") ";
-            }
-            cout << endl;
+    // Search for a key and return its value
+    bool search(string_view key, V& value) const {
+        const V* found = find(key);
+        if (found == nullptr) {
+            return false;
         }
+        value = *found;
+        return true;
     }
     
-    // Get the current load factor
-    float loadFactor() {
-        int itemCount = 0;
-        
-        // Count total number of elements
-        for (int i = 0; i < tableSize; i++) {
-            itemCount += table[i].size();
+    // Number of stored key-value pairs
+    int size() const {
+        return header == nullptr ? 0 : static_cast<int>(header->itemCount);
+    }
+};
+
+// Per-insert latency percentiles while growing a table from empty.
+// The chaining engine migrates incrementally, the SwissTable engine
+// rehashes everything at once when it grows.
+template<typename Table>
+void benchmarkInsertLatency(const string& name, Table& table, int n) {
+    vector<long long> latency(n);
+    
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        auto t0 = chrono::steady_clock::now();
+        table.insert(i, i);
+        auto t1 = chrono::steady_clock::now();
+        latency[i] = chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count();
+    }
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    
+    sort(latency.begin(), latency.end());
+    cout << name << ": total " << totalMs << " ms"
+         << ", p50 " << latency[n / 2] << " ns"
+         << ", p99 " << latency[n * 99LL / 100] << " ns"
+         << ", p99.9 " << latency[n * 999LL / 1000] << " ns"
+         << ", max " << latency[n - 1] << " ns" << endl;
+}
+
+// Hash quality and speed of one hasher over a key set. Quality is measured
+// on the raw hash reduced with a mask, the way a power-of-two table uses it:
+// the fullest of 2^16 buckets and the chi-squared statistic against a
+// uniform spread, which is close to the bucket count for a good hash.
+template<typename Hasher, typename Key>
+void benchmarkHasher(const string& name, const vector<Key>& keys) {
+    Hasher hasher;
+    const size_t buckets = 1 << 16;
+    const int rounds = 10;
+    
+    size_t sink = 0;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (const Key& key : keys) {
+            sink += hasher(key);
         }
-        
-        return static_cast<float>(itemCount) / tableSize;
     }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / (rounds * keys.size());
     
-    // Get the size of the largest bucket
-    int maxBucketSize() {
-        int maxSize = 0;
-        
-        for (int i = 0; i < tableSize; i++) {
-            int bucketSize = table[i].size();
-            if (bucketSize > maxSize) {
-                maxSize = bucketSize;
+    vector<int> counts(buckets);
+    for (const Key& key : keys) {
+        counts[hasher(key) & (buckets - 1)]++;
+    }
+    double expected = static_cast<double>(keys.size()) / buckets;
+    double chiSquared = 0;
+    for (int count : counts) {
+        chiSquared += (count - expected) * (count - expected) / expected;
+    }
+    
+    cout << name << ": " << ns << " ns/hash, fullest bucket " << *max_element(counts.begin(), counts.end())
+         << ", chi^2 " << static_cast<long long>(chiSquared) << (sink == 1 ? " " : "") << endl;
+}
+
+// Build time with insert vs bulkInsert, then lookup time with one search per
+// key vs findBatch over batches of the given size
+template<typename Table>
+void benchmarkBatch(const string& name, int n, int batchSize) {
+    vector<pair<int, int>> pairs(n);
+    uint64_t state = 88172645463325252ull;
+    for (int i = 0; i < n; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        pairs[i] = make_pair(static_cast<int>(state >> 33), i);
+    }
+    
+    auto t0 = chrono::steady_clock::now();
+    Table looped(16);
+    for (const auto& kv : pairs) {
+        looped.insert(kv.first, kv.second);
+    }
+    auto t1 = chrono::steady_clock::now();
+    Table bulk(16);
+    bulk.bulkInsert(pairs);
+    auto t2 = chrono::steady_clock::now();
+    
+    // Query keys in an order unrelated to insertion, half of them present
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = (i & 1) ? pairs[(i * 7919LL) % n].first : static_cast<int>(i * 2654435761u);
+    }
+    
+    long long checksum = 0;
+    int value;
+    auto t3 = chrono::steady_clock::now();
+    for (int key : keys) {
+        if (bulk.search(key, value)) checksum += value;
+    }
+    auto t4 = chrono::steady_clock::now();
+    vector<int> batch;
+    vector<int*> found;
+    for (int start = 0; start < n; start += batchSize) {
+        batch.assign(keys.begin() + start, keys.begin() + min(n, start + batchSize));
+        bulk.findBatch(batch, found);
+        for (int* v : found) {
+            if (v != nullptr) checksum -= *v;
+        }
+    }
+    auto t5 = chrono::steady_clock::now();
+    
+    auto ms = [](chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    cout << name << ": insert loop " << ms(t0, t1) << " ms, bulkInsert " << ms(t1, t2) << " ms"
+         << ", search loop " << ms(t3, t4) << " ms, findBatch(" << batchSize << ") " << ms(t4, t5) << " ms"
+         << (checksum == 0 ? "" : " (checksum mismatch)") << endl;
+}
+
+// Cold start: rebuilding a string-keyed table from source data vs mapping
+// a snapshot of it and running a handful of lookups
+void benchmarkSnapshot(int n, int lookups) {
+    vector<pair<string, int>> source(n);
+    for (int i = 0; i < n; i++) {
+        source[i] = make_pair("key-" + to_string(i * 2654435761u), i);
+    }
+    string path = "/tmp/hashtable_bench.snap";
+    
+    auto t0 = chrono::steady_clock::now();
+    HashTable<string, int, SwissTable> table;
+    table.bulkInsert(source);
+    auto t1 = chrono::steady_clock::now();
+    bool written = writeSnapshot(table, path);
+    auto t2 = chrono::steady_clock::now();
+    
+    MappedHashTable<int> mapped;
+    long long checksum = 0;
+    auto t3 = chrono::steady_clock::now();
+    bool opened = mapped.open(path);
+    for (int i = 0; i < lookups; i++) {
+        int value;
+        if (mapped.search(source[(i * 7919LL) % n].first, value)) checksum += value;
+    }
+    auto t4 = chrono::steady_clock::now();
+    
+    auto ms = [](chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    cout << n << " keys: rebuild " << ms(t0, t1) << " ms, write snapshot " << ms(t1, t2) << " ms"
+         << ", open + " << lookups << " lookups " << ms(t3, t4) << " ms"
+         << (written && opened ? "" : " (snapshot I/O failed)") << " [" << checksum << "]" << endl;
+    remove(path.c_str());
+}
+
+// Damage a small snapshot in ways a valid header does not rule out and
+// check that opening or searching it fails cleanly: a header claiming a
+// full table, a slot count whose section sizes wrap around, slots pointing
+// past the keys section, and a table with no empty slot left to stop a miss
+void checkCorruptSnapshots() {
+    string path = "/tmp/hashtable_corrupt.snap";
+    HashTable<string, int, SwissTable> table;
+    for (int i = 0; i < 100; i++) {
+        table.insert("key-" + to_string(i), i);
+    }
+    string good;
+    if (writeSnapshot(table, path)) {
+        FILE* file = fopen(path.c_str(), "rb");
+        char buffer[4096];
+        size_t got;
+        while (file != nullptr && (got = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            good.append(buffer, got);
+        }
+        if (file != nullptr) fclose(file);
+    }
+    if (good.size() < sizeof(snapshot::Header)) {
+        cout << "corrupt snapshots: (snapshot I/O failed)" << endl;
+        return;
+    }
+    snapshot::Header header;
+    memcpy(&header, good.data(), sizeof(header));
+    
+    auto reopen = [&path](const string& data, MappedHashTable<int>& mapped) {
+        FILE* file = fopen(path.c_str(), "wb");
+        bool written = file != nullptr && fwrite(data.data(), 1, data.size(), file) == data.size();
+        if (file != nullptr) fclose(file);
+        return written && mapped.open(path);
+    };
+    auto withHeader = [&good](const snapshot::Header& changed) {
+        string data = good;
+        memcpy(&data[0], &changed, sizeof(changed));
+        return data;
+    };
+    auto withSlots = [&good, &header](const function<void(snapshot::Slot&)>& change) {
+        string data = good;
+        for (uint64_t i = 0; i < header.slotCount; i++) {
+            snapshot::Slot slot;
+            char* at = &data[header.slotsOffset + i * sizeof(slot)];
+            memcpy(&slot, at, sizeof(slot));
+            change(slot);
+            memcpy(at, &slot, sizeof(slot));
+        }
+        return data;
+    };
+    
+    int value;
+    MappedHashTable<int> intact, full, wrapping, farKeys, noEmptySlot;
+    snapshot::Header changed = header;
+    changed.itemCount = changed.slotCount;
+    bool ok = reopen(good, intact) && intact.search("key-7", value) && value == 7;
+    ok = ok && !reopen(withHeader(changed), full);
+    changed = header;
+    changed.slotCount = 1ull << 62;
+    ok = ok && !reopen(withHeader(changed), wrapping);
+    ok = ok && reopen(withSlots([](snapshot::Slot& slot) { slot.keyOffset = UINT64_MAX - 2; }), farKeys) &&
+         !farKeys.search("key-7", value);
+    ok = ok && reopen(withSlots([](snapshot::Slot& slot) { slot.keyLength = 1; }), noEmptySlot) &&
+         !noEmptySlot.search("missing", value);
+    cout << "corrupt snapshots" << (ok ? " rejected" : " (mismatch)") << endl;
+    remove(path.c_str());
+}
+
+// A single HashTable behind one mutex, the baseline for the concurrent table
+template<typename K, typename V>
+class LockedHashTable {
+private:
+    mutex lock;
+    HashTable<K, V> table;
+    
+public:
+    LockedHashTable(int size) : table(size) {}
+    
+    void insert(const K& key, const V& value) {
+        lock_guard<mutex> guard(lock);
+        table.insert(key, value);
+    }
+    
+    bool search(const K& key, V& value) {
+        lock_guard<mutex> guard(lock);
+        return table.search(key, value);
+    }
+};
+
+// Aggregate throughput of `threads` workers doing a mix of searches and
+// inserts over a shared key space; readPercent sets the mix
+template<typename Table>
+double benchmarkConcurrent(Table& table, int threads, int readPercent, int opsPerThread, int keySpace) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&table, t, readPercent, opsPerThread, keySpace]() {
+            uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+            int value;
+            for (int i = 0; i < opsPerThread; i++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                int key = static_cast<int>(state % keySpace);
+                if (static_cast<int>((state >> 32) % 100) < readPercent) {
+                    table.search(key, value);
+                } else {
+                    table.insert(key, i);
+                }
             }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return threads * static_cast<double>(opsPerThread) / seconds / 1e6;
+}
+
+// Resident set size in kB, or 0 where /proc is not available
+long residentKB() {
+    FILE* status = fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[256];
+    long kb = 0;
+    while (fgets(line, sizeof(line), status) != nullptr) {
+        if (strncmp(line, "VmRSS:", 6) == 0) {
+            kb = atol(line + 6);
+            break;
         }
-        
-        return maxSize;
     }
+    fclose(status);
+    return kb;
+}
+
+// Steady churn on one shard: insert i, remove i - window, so the live set
+// never grows while tombstones keep forcing same-capacity rehashes. Each
+// rehash retires an array; resident memory must level off rather than climb
+// with every step.
+void benchmarkChurn(int steps, int opsPerStep, int window) {
+    ConcurrentHashTable<int, int> table(1, window * 2);
+    vector<long> resident;
+    int next = 0;
+    auto start = chrono::steady_clock::now();
+    for (int step = 0; step < steps; step++) {
+        for (int i = 0; i < opsPerStep; i++, next++) {
+            table.insert(next, next);
+            if (next >= window) table.remove(next - window);
+        }
+        resident.push_back(residentKB());
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
     
-    // Resize the hash table
-    void resize(int newSize) {
-        // Save old table
-        vector<list<pair<K, V>>> oldTable = table;
-        
-        // Reset table with new size
-        tableSize = newSize;
-        table.clear();
-        table.resize(tableSize);
-        
-        // Rehash all elements
-        for (const auto& bucket : oldTable) {
-            for (const auto& kv : bucket) {
-                insert(kv.first, kv.second);
+    cout << steps << " x " << opsPerStep << " inserts with " << window << " live keys: " << ms << " ms, RSS";
+    for (long kb : resident) {
+        cout << " " << kb / 1024 << "MB";
+    }
+    // Allow for allocator noise, not for a retired array per rehash
+    bool bounded = resident.back() <= resident.front() + 8 * 1024;
+    cout << (table.size() == static_cast<size_t>(window) ? "" : " (size mismatch)")
+         << (bounded ? "" : " (memory growing)") << endl;
+}
+
+void runBenchmarks() {
+    const int n = 4000000;
+    cout << "Insert latency, " << n << " keys:" << endl;
+    HashTable<int, int> chained(16);
+    HashTable<int, int> sparse(16, 0.25f);
+    HashTable<int, int, SwissTable> flat(16);
+    benchmarkInsertLatency("Chaining (incremental)", chained, n);
+    benchmarkInsertLatency("Chaining, max load 0.25", sparse, n);
+    benchmarkInsertLatency("SwissTable (full rehash)", flat, n);
+    
+    const int hashKeys = 1 << 20;
+    vector<uint64_t> sequential(hashKeys), strided(hashKeys);
+    vector<string> words(hashKeys);
+    for (int i = 0; i < hashKeys; i++) {
+        sequential[i] = i;
+        strided[i] = static_cast<uint64_t>(i) << 16;
+        words[i] = "user:" + to_string(i);
+    }
+    cout << "\nHash functions, " << hashKeys << " keys into " << (1 << 16) << " masked buckets:" << endl;
+    benchmarkHasher<hash<uint64_t>>("std::hash, sequential ints", sequential);
+    benchmarkHasher<FastHash<uint64_t>>("FastHash,  sequential ints", sequential);
+    benchmarkHasher<hash<uint64_t>>("std::hash, strided ints", strided);
+    benchmarkHasher<FastHash<uint64_t>>("FastHash,  strided ints", strided);
+    benchmarkHasher<hash<string>>("std::hash, strings", words);
+    benchmarkHasher<FastHash<string>>("FastHash,  strings", words);
+    
+    const int batchKeys = 2000000;
+    cout << "\nBatched build and lookup, " << batchKeys << " keys:" << endl;
+    for (int batchSize : {64, 1024}) {
+        benchmarkBatch<HashTable<int, int>>("Chaining", batchKeys, batchSize);
+        benchmarkBatch<HashTable<int, int, SwissTable>>("SwissTable", batchKeys, batchSize);
+    }
+    
+    cout << "\nRetired arrays under churn:" << endl;
+    benchmarkChurn(5, 4000000, 1000);
+    
+    cout << "\nCold start from a mapped snapshot:" << endl;
+    benchmarkSnapshot(2000000, 1000);
+    checkCorruptSnapshots();
+    
+    const int keySpace = 1 << 20;
+    const int opsPerThread = 1000000;
+    int maxThreads = max(2, static_cast<int>(thread::hardware_concurrency()));
+    cout << "\nConcurrent throughput (Mops/s), " << keySpace << " keys:" << endl;
+    for (int readPercent : {100, 95, 80, 50}) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            ConcurrentHashTable<int, int> sharded(256, keySpace);
+            LockedHashTable<int, int> locked(keySpace);
+            for (int i = 0; i < keySpace; i += 2) {
+                sharded.insert(i, i);
+                locked.insert(i, i);
             }
+            cout << readPercent << "% reads, " << threads << " threads: "
+                 << "sharded " << benchmarkConcurrent(sharded, threads, readPercent, opsPerThread, keySpace)
+                 << ", single mutex " << benchmarkConcurrent(locked, threads, readPercent, opsPerThread, keySpace)
+                 << endl;
         }
     }
-};
+}
 
 // Example usage with string keys and int values
-int main() {
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        runBenchmarks();
+        return 0;
+    }
+    
     HashTable<string, int> ht(7);
     
     // Insert some key-value pairs
@@ -189,6 +2206,9 @@ int main() {
     
     // Search for keys
     int value;
+    if (int* cherry = ht.find("cherry")) {
+        cout << "\nFound cherry in place with value: " << *cherry << endl;
+    }
     if (ht.search("apple", value)) {
         cout << "\nFound apple with value: " << value << endl;
     } else {
@@ -233,8 +2253,8 @@ int main() {
     cout << "Max bucket size: " << ht.maxBucketSize() << endl;
     
     // Resize the hash table
-    cout << "\nResizing hash table to size 15..." << endl;
-    ht.resize(15);
+    cout << "\nResizing hash table to size 16..." << endl;
+    ht.resize(16);
     
     // Display after resizing
     cout << "After resizing:" << endl;
@@ -247,11 +2267,56 @@ int main() {
     ht2.insert(2, "two");
     
     ht2.insert(3, "three");
-    ht2.insert(11, "eleven"); // Should hash to the same bucket as 1
-    ht2.insert(22, "twenty-two"); // Should hash to the same bucket as 2
+    ht2.insert(11, "eleven"); // Shared a bucket with 1 under the identity std::hash
+    ht2.insert(22, "twenty-two"); // Shared a bucket with 2 under the identity std::hash
     
     cout << "\nHash Table with Integer Keys:" << endl;
     ht2.display();
     
+    // Dump the string table and query the file in place
+    string snapshotPath = "/tmp/hashtable_demo.snap";
+    MappedHashTable<int> mapped;
+    if (writeSnapshot(ht, snapshotPath) && mapped.open(snapshotPath)) {
+        cout << "\nMapped snapshot with " << mapped.size() << " keys" << endl;
+        const int* cherry = mapped.find("cherry");
+        cout << "cherry: " << (cherry ? to_string(*cherry) : "not found") << endl;
+        cout << "banana: " << (mapped.find("banana") ? "found" : "not found") << endl;
+    } else {
+        cout << "\nCouldn't write or map " << snapshotPath << endl;
+    }
+    remove(snapshotPath.c_str());
+    
+    // The same API with the open-addressing SwissTable engine
+    HashTable<int, int, SwissTable> flat;
+    for (int i = 0; i < 1000; i++) {
+        flat.insert(i, i * i);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        flat.remove(i);
+    }
+    
+    int square;
+    cout << "\nSwissTable engine with " << flat.getKeys().size() << " keys" << endl;
+    cout << "Search 31: " << (flat.search(31, square) ? to_string(square) : "not found") << endl;
+    cout << "Search 32: " << (flat.search(32, square) ? to_string(square) : "not found") << endl;
+    cout << "Load factor: " << flat.loadFactor() << endl;
+    cout << "Longest probe (groups): " << flat.maxBucketSize() << endl;
+    
+    // A table shared between threads, sharded with per-shard locks
+    ConcurrentHashTable<int, int> shared(16);
+    vector<thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&shared, t]() {
+            for (int i = t; i < 10000; i += 4) {
+                shared.insert(i, -i);
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    cout << "\nConcurrent table with " << shared.shardCount() << " shards holds " << shared.size() << " keys" << endl;
+    cout << "Search 9999: " << (shared.search(9999, square) ? to_string(square) : "not found") << endl;
+    
     return 0;
 }
\ No newline at end of file
@@ -7,152 +7,440 @@
 #include <ctime>
 #include <cmath>
 #include <limits>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <set>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <algorithm>
+#include <random>
+#include <iterator>
+#include <type_traits>
 
 using namespace std;
 
 
 const int MAX_LEVEL = 16;
 
+const size_t CACHE_LINE = 64;
 
+
+// The tower of forward pointers is stored inline after the key and value, so
+// a node is one variable-length block and a level hop costs a single cache miss.
+template<typename K, typename V>
 class Node {
 public:
-    int key;
+    K key;
+    V value;
+    int level;
     
-    Node** forward;
+    Node* forward[1];
     
-    Node(int k, int level) : key(k) {
-        
-        forward = new Node*[level + 1];
-        
+    static size_t bytesFor(int level) {
+        return sizeof(Node) + level * sizeof(Node*);
+    }
+};
+
+
+// Bump allocator for the nodes of one list. Freed nodes are kept on a free
+// list per level and reused by later inserts of the same height.
+template<typename NodeType>
+class NodeArena {
+private:
+    static const size_t CHUNK_BYTES = 1 << 20;
+    
+    vector<char*> chunks;
+    char* cursor;
+    char* limit;
+    
+    NodeType* freeLists[MAX_LEVEL + 1];
+    
+public:
+    NodeArena() : cursor(nullptr), limit(nullptr) {
+        for (int i = 0; i <= MAX_LEVEL; i++) {
+            freeLists[i] = nullptr;
+        }
+    }
+    
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+    
+    ~NodeArena() {
+        for (char* chunk : chunks) {
+            ::operator delete(chunk);
+        }
+    }
+    
+    NodeType* allocate(int level) {
+        NodeType* node = freeLists[level];
+        if (node != nullptr) {
+            freeLists[level] = node->forward[0];
+            return node;
+        }
         
-        for (int i = 0; i <= level; i++) {
-            forward[i] = nullptr;
+        // Keep every node aligned for its key and value
+        size_t align = alignof(NodeType);
+        size_t bytes = (NodeType::bytesFor(level) + align - 1) / align * align;
+        if (cursor == nullptr || static_cast<size_t>(limit - cursor) < bytes) {
+            cursor = static_cast<char*>(::operator new(CHUNK_BYTES));
+            limit = cursor + CHUNK_BYTES;
+            chunks.push_back(cursor);
         }
+        node = reinterpret_cast<NodeType*>(cursor);
+        cursor += bytes;
+        return node;
     }
     
-    ~Node() {
-        delete[] forward;
+    void release(NodeType* node) {
+        node->forward[0] = freeLists[node->level];
+        freeLists[node->level] = node;
     }
 };
 
+
+// Ordered map from K to V. Iteration, lower_bound and range scans walk the
+// level-0 list in key order.
+template<typename K, typename V>
 class SkipList {
+public:
+    typedef Node<K, V> NodeType;
+    
+    class iterator {
+    private:
+        NodeType* node;
+        
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef NodeType value_type;
+        typedef ptrdiff_t difference_type;
+        typedef NodeType* pointer;
+        typedef NodeType& reference;
+        
+        explicit iterator(NodeType* n = nullptr) : node(n) {}
+        
+        NodeType& operator*() const {
+            return *node;
+        }
+        
+        NodeType* operator->() const {
+            return node;
+        }
+        
+        iterator& operator++() {
+            node = node->forward[0];
+            return *this;
+        }
+        
+        iterator operator++(int) {
+            iterator previous = *this;
+            node = node->forward[0];
+            return previous;
+        }
+        
+        bool operator==(const iterator& other) const {
+            return node == other.node;
+        }
+        
+        bool operator!=(const iterator& other) const {
+            return node != other.node;
+        }
+    };
+    
+    
+    // Finger search for lookups with locality. The cursor keeps the
+    // predecessors of the last key it sought and climbs from level 0 only
+    // until it can pass the target, so a seek costs O(log d) for a target d
+    // entries away. Inserting into the list keeps a cursor valid; removing
+    // may free its fingers, so call reset() after a remove.
+    class cursor {
+    private:
+        SkipList* list;
+        NodeType* path[MAX_LEVEL + 1];
+        
+    public:
+        explicit cursor(SkipList& l) : list(&l) {
+            reset();
+        }
+        
+        void reset() {
+            for (int i = 0; i <= MAX_LEVEL; i++) {
+                path[i] = list->header;
+            }
+        }
+        
+        // First entry with a key not below key
+        iterator seek(const K& key) {
+            NodeType* header = list->header;
+            int top = list->level;
+            
+            
+            // Climb while this level's finger is not before key (moving
+            // backwards), or the level above can still move towards key
+            int i = 0;
+            while (i < top) {
+                bool behind = path[i] != header && !(path[i]->key < key);
+                NodeType* ahead = path[i + 1]->forward[i + 1];
+                if (!behind && (ahead == nullptr || !(ahead->key < key))) {
+                    break;
+                }
+                i++;
+            }
+            
+            NodeType* current = path[i];
+            if (current != header && !(current->key < key)) {
+                current = header;
+                i = top;
+            }
+            
+            
+            for (; i >= 0; i--) {
+                while (current->forward[i] != nullptr && current->forward[i]->key < key) {
+                    current = current->forward[i];
+                }
+                
+                path[i] = current;
+            }
+            
+            return iterator(current->forward[0]);
+        }
+        
+        V* find(const K& key) {
+            iterator it = seek(key);
+            return it != list->end() && it->key == key ? &it->value : nullptr;
+        }
+    };
+    
 private:
     
     int level;
     
     
-    Node* header;
+    NodeType* header;
     
+    NodeArena<NodeType> arena;
     
-    int randomLevel() {
-        int lvl = 0;
-        float r = static_cast<float>(rand()) / RAND_MAX;
-        
-        
-        while (r < 0.5 && lvl < MAX_LEVEL) {
-            lvl++;
-            r = static_cast<float>(rand()) / RAND_MAX;
+    
+    // The header tower is searched on every operation, so it gets whole cache lines
+    static size_t headerBytes() {
+        return (NodeType::bytesFor(MAX_LEVEL) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+    }
+    
+    static size_t headerAlign() {
+        return max(CACHE_LINE, alignof(NodeType));
+    }
+    
+    NodeType* createNode(const K& key, const V& value, int lvl) {
+        NodeType* node = arena.allocate(lvl);
+        new (&node->key) K(key);
+        new (&node->value) V(value);
+        node->level = lvl;
+        for (int i = 0; i <= lvl; i++) {
+            node->forward[i] = nullptr;
         }
-        
-        return lvl;
+        return node;
     }
     
-public:
-    SkipList() : level(0) {
-        
-        header = new Node(numeric_limits<int>::min(), MAX_LEVEL);
-        
-        
-        srand(time(nullptr));
+    void destroyNode(NodeType* node) {
+        node->key.~K();
+        node->value.~V();
+        arena.release(node);
     }
     
-    ~SkipList() {
-        Node* current = header;
-        Node* next;
-        
-        while (current != nullptr) {
-            next = current->forward[0];
-            delete current;
-            current = next;
+    
+    // Last node with a key below key, or the header
+    NodeType* findPredecessor(const K& key) {
+        NodeType* current = header;
+        for (int i = level; i >= 0; i--) {
+            while (current->forward[i] != nullptr && current->forward[i]->key < key) {
+                current = current->forward[i];
+            }
         }
+        return current;
     }
     
     
-    bool search(int key) {
-        Node* current = header;
+    // Per-list xorshift state, so lists never share a generator
+    uint64_t rngState;
+    
+    
+    int randomLevel() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 7;
+        rngState ^= rngState << 17;
+        
+        // Trailing zeros of a uniform word are geometric with p = 1/2
+        return __builtin_ctzll(rngState | (1ull << MAX_LEVEL));
+    }
+    
+    
+    // Insert or update key, starting each level's walk from the finger in
+    // update[] when it is further along than the node reached from above.
+    // Fingers must be before key; afterwards they are key's predecessors.
+    bool insertFrom(NodeType** update, const K& key, const V& value) {
+        NodeType* current = header;
         
         
         for (int i = level; i >= 0; i--) {
             
+            if (update[i] != header && (current == header || current->key < update[i]->key)) {
+                current = update[i];
+            }
             while (current->forward[i] != nullptr && current->forward[i]->key < key) {
                 current = current->forward[i];
             }
+            
+            update[i] = current;
         }
         
         
         current = current->forward[0];
         
         
-        return (current != nullptr && current->key == key);
+        if (current != nullptr && current->key == key) {
+            current->value = value;
+            return false;
+        }
+        
+        int randomLvl = randomLevel();
+        
+        
+        
+        if (randomLvl > level) {
+            for (int i = level + 1; i <= randomLvl; i++) {
+                update[i] = header;
+            }
+            
+            level = randomLvl;
+        }
+        
+        
+        NodeType* newNode = createNode(key, value, randomLvl);
+        
+        
+        for (int i = 0; i <= randomLvl; i++) {
+            newNode->forward[i] = update[i]->forward[i];
+            update[i]->forward[i] = newNode;
+        }
+        
+        return true;
     }
     
-    
-    void insert(int key) {
-        Node* current = header;
-        
+public:
+    SkipList() : level(0) {
         
-        Node* update[MAX_LEVEL + 1];
+        // Only the tower of the header is used; its key and value are never constructed
+        header = static_cast<NodeType*>(::operator new(headerBytes(), align_val_t(headerAlign())));
+        header->level = MAX_LEVEL;
         for (int i = 0; i <= MAX_LEVEL; i++) {
-            update[i] = nullptr;
+            header->forward[i] = nullptr;
         }
         
         
-        for (int i = level; i >= 0; i--) {
-            
-            while (current->forward[i] != nullptr && current->forward[i]->key < key) {
-                current = current->forward[i];
+        rngState = (static_cast<uint64_t>(time(nullptr)) << 32) ^ reinterpret_cast<uintptr_t>(this) ^ 0x9E3779B97F4A7C15ull;
+    }
+    
+    SkipList(const SkipList&) = delete;
+    SkipList& operator=(const SkipList&) = delete;
+    
+    
+    ~SkipList() {
+        if (!is_trivially_destructible<K>::value || !is_trivially_destructible<V>::value) {
+            for (NodeType* node = header->forward[0]; node != nullptr; node = node->forward[0]) {
+                node->key.~K();
+                node->value.~V();
             }
-            
-            update[i] = current;
         }
+        ::operator delete(header, align_val_t(headerAlign()));
+    }
+    
+    
+    bool search(const K& key) {
+        return find(key) != nullptr;
+    }
+    
+    
+    V* find(const K& key) {
+        NodeType* current = findPredecessor(key)->forward[0];
         
         
-        current = current->forward[0];
+        return (current != nullptr && current->key == key) ? &current->value : nullptr;
+    }
+    
+    
+    bool insert(const K& key, const V& value = V()) {
+        NodeType* update[MAX_LEVEL + 1];
+        for (int i = 0; i <= MAX_LEVEL; i++) {
+            update[i] = header;
+        }
         
+        return insertFrom(update, key, value);
+    }
+    
+    
+    // Insert many pairs: the batch is sorted, then each insert resumes from
+    // the fingers left by the previous key instead of the top of the list
+    template<typename Range>
+    void insertBatch(const Range& batch) {
+        vector<pair<K, V>> sorted(std::begin(batch), std::end(batch));
+        stable_sort(sorted.begin(), sorted.end(),
+                    [](const pair<K, V>& a, const pair<K, V>& b) { return a.first < b.first; });
         
-        if (current == nullptr || current->key != key) {
-            
-            int randomLvl = randomLevel();
-            
-            
-            
-            if (randomLvl > level) {
-                for (int i = level + 1; i <= randomLvl; i++) {
-                    update[i] = header;
-                }
-                
-                level = randomLvl;
+        NodeType* update[MAX_LEVEL + 1];
+        for (int i = 0; i <= MAX_LEVEL; i++) {
+            update[i] = header;
+        }
+        
+        // Keys arrive in order, so the predecessors of one key are valid
+        // fingers for the next; a repeated key just updates the value again
+        for (const auto& kv : sorted) {
+            insertFrom(update, kv.first, kv.second);
+        }
+    }
+    
+    
+    // Build from pairs sorted by key in one linear pass, appending every
+    // node to the tail of each level it occupies. Falls back to insertBatch
+    // if the list is not empty or the input is not sorted.
+    template<typename Range>
+    void buildFromSorted(const Range& sorted) {
+        bool ascending = is_sorted(std::begin(sorted), std::end(sorted),
+                                   [](const pair<K, V>& a, const pair<K, V>& b) { return a.first < b.first; });
+        if (header->forward[0] != nullptr || !ascending) {
+            insertBatch(sorted);
+            return;
+        }
+        
+        NodeType* tail[MAX_LEVEL + 1];
+        for (int i = 0; i <= MAX_LEVEL; i++) {
+            tail[i] = header;
+        }
+        
+        for (const auto& kv : sorted) {
+            if (tail[0] != header && tail[0]->key == kv.first) {
+                tail[0]->value = kv.second;
+                continue;
             }
             
-            
-            Node* newNode = new Node(key, randomLvl);
-            
-            
-            for (int i = 0; i <= randomLvl; i++) {
-                newNode->forward[i] = update[i]->forward[i];
-                update[i]->forward[i] = newNode;
+            int lvl = randomLevel();
+            NodeType* node = createNode(kv.first, kv.second, lvl);
+            for (int i = 0; i <= lvl; i++) {
+                tail[i]->forward[i] = node;
+                tail[i] = node;
             }
-            
-            cout << "Successfully inserted key " << key << endl;
+            level = max(level, lvl);
         }
     }
     
     
-    void remove(int key) {
-        Node* current = header;
+    bool remove(const K& key) {
+        NodeType* current = header;
         
         
-        Node* update[MAX_LEVEL + 1];
+        NodeType* update[MAX_LEVEL + 1];
         
         
         for (int i = level; i >= 0; i--) {
@@ -183,18 +471,69 @@ public:
                 level--;
             }
             
-            delete current;
-            cout << "Successfully deleted key " << key << endl;
-        } else {
-            cout << "Key " << key << " not found in the list" << endl;
+            destroyNode(current);
+            return true;
         }
+        
+        return false;
+    }
+    
+    
+    iterator begin() {
+        return iterator(header->forward[0]);
+    }
+    
+    iterator end() {
+        return iterator(nullptr);
+    }
+    
+    
+    cursor makeCursor() {
+        return cursor(*this);
+    }
+    
+    
+    // First entry with a key not below key
+    iterator lower_bound(const K& key) {
+        return iterator(findPredecessor(key)->forward[0]);
+    }
+    
+    
+    // Call visit(key, value) for every entry with lo <= key < hi, in order.
+    // The top of each node's tower points furthest ahead along the level-0
+    // run, so it is prefetched while the nearer nodes are being visited.
+    template<typename F>
+    void range(const K& lo, const K& hi, F visit) {
+        for (NodeType* node = findPredecessor(lo)->forward[0]; node != nullptr && node->key < hi; node = node->forward[0]) {
+            if (node->level > 0 && node->forward[node->level] != nullptr) {
+                __builtin_prefetch(node->forward[node->level]);
+            }
+            if (node->forward[0] != nullptr) {
+                __builtin_prefetch(node->forward[0]->forward[0]);
+            }
+            visit(node->key, node->value);
+        }
+    }
+    
+    
+    size_t rangeCount(const K& lo, const K& hi) {
+        size_t count = 0;
+        range(lo, hi, [&count](const K&, const V&) { count++; });
+        return count;
+    }
+    
+    
+    V rangeSum(const K& lo, const K& hi) {
+        V sum = V();
+        range(lo, hi, [&sum](const K&, const V& value) { sum += value; });
+        return sum;
     }
     
     
     void display() {
         cout << "\n*****Skip List*****" << endl;
         for (int i = 0; i <= level; i++) {
-            Node* node = header->forward[i];
+            NodeType* node = header->forward[i];
             cout << "Level " << i << ": ";
             while (node != nullptr) {
                 cout << node->key << " ";
@@ -206,20 +545,687 @@ public:
 };
 
 
-int main() {
-    SkipList list;
+// Epoch-based reclamation: a retired node is freed only after the global epoch
+// has advanced twice, by which point no thread can still be reading it.
+class EpochDomain {
+public:
+    static const int MAX_THREADS = 256;
+    
+private:
+    static const uint64_t INACTIVE = ~0ull;
+    static const size_t SCAN_THRESHOLD = 64;
+    
+    struct Retired {
+        void* ptr;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+    
+    struct alignas(64) ThreadRecord {
+        atomic<uint64_t> epoch;
+        atomic<bool> inUse;
+        int nesting;
+        vector<Retired> limbo;
+        
+        ThreadRecord() : epoch(INACTIVE), inUse(false), nesting(0) {}
+    };
     
+    atomic<uint64_t> globalEpoch;
+    ThreadRecord records[MAX_THREADS];
     
-    list.insert(3);
-    list.insert(6);
-    list.insert(7);
-    list.insert(9);
-    list.insert(12);
-    list.insert(19);
-    list.insert(17);
-    list.insert(26);
-    list.insert(21);
-    list.insert(25);
+    mutex orphanLock;
+    vector<Retired> orphans;
+    
+    
+    struct Registration {
+        ThreadRecord* record = nullptr;
+        
+        ~Registration() {
+            if (record != nullptr) {
+                EpochDomain::instance().release(record);
+            }
+        }
+    };
+    
+    EpochDomain() : globalEpoch(1) {}
+    
+    // Runs at exit, after every thread has left; nothing can be read any more
+    ~EpochDomain() {
+        freeExpired(orphans, INACTIVE);
+        for (int i = 0; i < MAX_THREADS; i++) {
+            freeExpired(records[i].limbo, INACTIVE);
+        }
+    }
+    
+    ThreadRecord& local() {
+        static thread_local Registration registration;
+        if (registration.record == nullptr) {
+            for (int i = 0; ; i = (i + 1) % MAX_THREADS) {
+                bool expected = false;
+                if (!records[i].inUse.load(memory_order_relaxed) &&
+                    records[i].inUse.compare_exchange_strong(expected, true, memory_order_acquire)) {
+                    registration.record = &records[i];
+                    break;
+                }
+            }
+        }
+        return *registration.record;
+    }
+    
+    void release(ThreadRecord* record) {
+        if (!record->limbo.empty()) {
+            lock_guard<mutex> guard(orphanLock);
+            orphans.insert(orphans.end(), record->limbo.begin(), record->limbo.end());
+            record->limbo.clear();
+        }
+        record->inUse.store(false, memory_order_release);
+    }
+    
+    
+    bool tryAdvance() {
+        uint64_t current = globalEpoch.load(memory_order_seq_cst);
+        for (int i = 0; i < MAX_THREADS; i++) {
+            uint64_t e = records[i].epoch.load(memory_order_seq_cst);
+            if (e != INACTIVE && e != current) {
+                return false;
+            }
+        }
+        globalEpoch.compare_exchange_strong(current, current + 1, memory_order_seq_cst);
+        return true;
+    }
+    
+    
+    static void freeExpired(vector<Retired>& list, uint64_t now) {
+        size_t kept = 0;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (list[i].epoch + 2 <= now) {
+                list[i].deleter(list[i].ptr);
+            } else {
+                list[kept++] = list[i];
+            }
+        }
+        list.resize(kept);
+    }
+    
+public:
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+    
+    void enter() {
+        ThreadRecord& record = local();
+        if (record.nesting++ == 0) {
+            record.epoch.store(globalEpoch.load(memory_order_relaxed), memory_order_seq_cst);
+        }
+    }
+    
+    void exit() {
+        ThreadRecord& record = local();
+        if (--record.nesting == 0) {
+            record.epoch.store(INACTIVE, memory_order_release);
+        }
+    }
+    
+    // Free ptr once every thread that might still see it has left its critical section
+    void retire(void* ptr, void (*deleter)(void*)) {
+        ThreadRecord& record = local();
+        record.limbo.push_back(Retired{ptr, deleter, globalEpoch.load(memory_order_relaxed)});
+        
+        if (record.limbo.size() >= SCAN_THRESHOLD) {
+            tryAdvance();
+            uint64_t now = globalEpoch.load(memory_order_relaxed);
+            freeExpired(record.limbo, now);
+            
+            unique_lock<mutex> guard(orphanLock, try_to_lock);
+            if (guard.owns_lock() && !orphans.empty()) {
+                freeExpired(orphans, now);
+            }
+        }
+    }
+};
+
+class EpochGuard {
+public:
+    EpochGuard() {
+        EpochDomain::instance().enter();
+    }
+    
+    ~EpochGuard() {
+        EpochDomain::instance().exit();
+    }
+    
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+
+// Lock-free skip list (Herlihy-Shavit): nodes are linked bottom-up with CAS
+// and deleted by marking the low bit of their forward pointers top-down.
+// Traversals snip marked nodes; search only skips them, so it never retries.
+template<typename K>
+class ConcurrentSkipList {
+private:
+    struct CNode {
+        K key;
+        int topLevel;
+        
+        // Whichever of the inserter and the remover finishes last retires the node
+        atomic<int> handoff;
+        
+        atomic<uintptr_t> forward[1];
+    };
+    
+    CNode* header;
+    atomic<long long> count;
+    
+    
+    static CNode* pointer(uintptr_t word) {
+        return reinterpret_cast<CNode*>(word & ~static_cast<uintptr_t>(1));
+    }
+    
+    static bool marked(uintptr_t word) {
+        return (word & 1) != 0;
+    }
+    
+    static uintptr_t word(CNode* node) {
+        return reinterpret_cast<uintptr_t>(node);
+    }
+    
+    
+    static CNode* createNode(const K& key, int topLevel) {
+        size_t bytes = sizeof(CNode) + topLevel * sizeof(atomic<uintptr_t>);
+        CNode* node = static_cast<CNode*>(::operator new(bytes));
+        new (&node->key) K(key);
+        node->topLevel = topLevel;
+        new (&node->handoff) atomic<int>(0);
+        for (int i = 0; i <= topLevel; i++) {
+            new (&node->forward[i]) atomic<uintptr_t>(0);
+        }
+        return node;
+    }
+    
+    static void destroyNode(void* ptr) {
+        CNode* node = static_cast<CNode*>(ptr);
+        node->key.~K();
+        ::operator delete(node);
+    }
+    
+    
+    static int randomLevel() {
+        static thread_local uint64_t state = 0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        
+        // Trailing zeros of a uniform word are geometric with p = 1/2
+        return __builtin_ctzll(state | (1ull << MAX_LEVEL));
+    }
+    
+    
+    // Fill preds/succs around key at every level, snipping marked nodes on the way
+    bool find(const K& key, CNode** preds, CNode** succs) {
+    retry:
+        CNode* pred = header;
+        CNode* curr = nullptr;
+        for (int i = MAX_LEVEL; i >= 0; i--) {
+            curr = pointer(pred->forward[i].load(memory_order_acquire));
+            while (curr != nullptr) {
+                uintptr_t succ = curr->forward[i].load(memory_order_acquire);
+                while (marked(succ)) {
+                    uintptr_t expected = word(curr);
+                    if (!pred->forward[i].compare_exchange_strong(expected, succ & ~static_cast<uintptr_t>(1),
+                                                                  memory_order_acq_rel)) {
+                        goto retry;
+                    }
+                    curr = pointer(succ);
+                    if (curr == nullptr) break;
+                    succ = curr->forward[i].load(memory_order_acquire);
+                }
+                if (curr == nullptr || !(curr->key < key)) break;
+                pred = curr;
+                curr = pointer(succ);
+            }
+            preds[i] = pred;
+            succs[i] = curr;
+        }
+        return curr != nullptr && !(key < curr->key);
+    }
+    
+    
+    void finish(CNode* node) {
+        if (node->handoff.fetch_add(1, memory_order_acq_rel) == 1) {
+            // Both parties are done; unlink any level the inserter linked late
+            CNode* preds[MAX_LEVEL + 1];
+            CNode* succs[MAX_LEVEL + 1];
+            find(node->key, preds, succs);
+            EpochDomain::instance().retire(node, &ConcurrentSkipList::destroyNode);
+        }
+    }
+    
+public:
+    ConcurrentSkipList() : count(0) {
+        header = createNode(K(), MAX_LEVEL);
+    }
+    
+    ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+    ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+    
+    // Not safe against concurrent operations; nodes already retired are freed by the epoch domain
+    ~ConcurrentSkipList() {
+        CNode* current = header;
+        while (current != nullptr) {
+            uintptr_t next = current->forward[0].load(memory_order_relaxed);
+            if (current == header || !marked(next)) {
+                destroyNode(current);
+            }
+            current = pointer(next);
+        }
+    }
+    
+    
+    bool search(const K& key) {
+        EpochGuard guard;
+        CNode* pred = header;
+        CNode* curr = nullptr;
+        for (int i = MAX_LEVEL; i >= 0; i--) {
+            curr = pointer(pred->forward[i].load(memory_order_acquire));
+            while (curr != nullptr) {
+                uintptr_t succ = curr->forward[i].load(memory_order_acquire);
+                if (marked(succ)) {
+                    curr = pointer(succ);
+                } else if (curr->key < key) {
+                    pred = curr;
+                    curr = pointer(succ);
+                } else {
+                    break;
+                }
+            }
+        }
+        return curr != nullptr && !(key < curr->key) &&
+               !marked(curr->forward[0].load(memory_order_acquire));
+    }
+    
+    
+    bool insert(const K& key) {
+        EpochGuard guard;
+        int topLevel = randomLevel();
+        CNode* preds[MAX_LEVEL + 1];
+        CNode* succs[MAX_LEVEL + 1];
+        
+        CNode* node;
+        while (true) {
+            if (find(key, preds, succs)) {
+                return false;
+            }
+            
+            node = createNode(key, topLevel);
+            for (int i = 0; i <= topLevel; i++) {
+                node->forward[i].store(word(succs[i]), memory_order_relaxed);
+            }
+            
+            // Linking level 0 is the linearization point
+            uintptr_t expected = word(succs[0]);
+            if (preds[0]->forward[0].compare_exchange_strong(expected, word(node), memory_order_acq_rel)) {
+                break;
+            }
+            destroyNode(node);
+        }
+        count.fetch_add(1, memory_order_relaxed);
+        
+        for (int i = 1; i <= topLevel; i++) {
+            while (true) {
+                // Point the node at the new successor unless a remover has marked this level
+                uintptr_t current = node->forward[i].load(memory_order_acquire);
+                if (marked(current)) {
+                    finish(node);
+                    return true;
+                }
+                if (current != word(succs[i]) &&
+                    !node->forward[i].compare_exchange_strong(current, word(succs[i]), memory_order_acq_rel)) {
+                    finish(node);
+                    return true;
+                }
+                
+                uintptr_t expected = word(succs[i]);
+                if (preds[i]->forward[i].compare_exchange_strong(expected, word(node), memory_order_acq_rel)) {
+                    break;
+                }
+                
+                find(key, preds, succs);
+                if (marked(node->forward[0].load(memory_order_acquire))) {
+                    finish(node);
+                    return true;
+                }
+            }
+        }
+        
+        finish(node);
+        return true;
+    }
+    
+    
+    bool remove(const K& key) {
+        EpochGuard guard;
+        CNode* preds[MAX_LEVEL + 1];
+        CNode* succs[MAX_LEVEL + 1];
+        
+        if (!find(key, preds, succs)) {
+            return false;
+        }
+        CNode* node = succs[0];
+        
+        for (int i = node->topLevel; i >= 1; i--) {
+            uintptr_t succ = node->forward[i].load(memory_order_acquire);
+            while (!marked(succ)) {
+                node->forward[i].compare_exchange_weak(succ, succ | 1, memory_order_acq_rel);
+            }
+        }
+        
+        // Marking level 0 is the linearization point; only one remover wins it
+        uintptr_t succ = node->forward[0].load(memory_order_acquire);
+        while (true) {
+            if (marked(succ)) {
+                return false;
+            }
+            if (node->forward[0].compare_exchange_weak(succ, succ | 1, memory_order_acq_rel)) {
+                break;
+            }
+        }
+        count.fetch_sub(1, memory_order_relaxed);
+        
+        find(key, preds, succs);
+        finish(node);
+        return true;
+    }
+    
+    
+    long long size() {
+        return count.load(memory_order_relaxed);
+    }
+};
+
+
+template<typename Set>
+double benchmarkMixed(Set& set, int threads, int searchPercent, int opsPerThread, int keySpace) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&set, t, searchPercent, opsPerThread, keySpace]() {
+            uint64_t state = 0x9E3779B97F4A7C15ull * (t + 1);
+            for (int i = 0; i < opsPerThread; i++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                int key = static_cast<int>(state % keySpace);
+                int op = static_cast<int>((state >> 32) % 100);
+                if (op < searchPercent) {
+                    set.search(key);
+                } else if (op < searchPercent + (100 - searchPercent) / 2) {
+                    set.insert(key);
+                } else {
+                    set.remove(key);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return threads * static_cast<double>(opsPerThread) / seconds / 1e6;
+}
+
+
+class LockedSet {
+private:
+    mutex lock;
+    set<int> keys;
+    
+public:
+    bool search(int key) {
+        lock_guard<mutex> guard(lock);
+        return keys.count(key) != 0;
+    }
+    
+    bool insert(int key) {
+        lock_guard<mutex> guard(lock);
+        return keys.insert(key).second;
+    }
+    
+    bool remove(int key) {
+        lock_guard<mutex> guard(lock);
+        return keys.erase(key) != 0;
+    }
+};
+
+
+void benchmarkSearchLatency(int n, int lookups) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i * 2;
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(42));
+    
+    SkipList<int, int> list;
+    auto buildStart = chrono::steady_clock::now();
+    for (int key : keys) {
+        list.insert(key);
+    }
+    double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - buildStart).count();
+    
+    uint64_t state = 88172645463325252ull;
+    long long hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        hits += list.search(static_cast<int>(state % (2ull * n)));
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / lookups;
+    
+    cout << n << " keys: build " << buildSeconds << " s, search " << ns << " ns/op (" << hits << " hits)" << endl;
+}
+
+
+// Lookups with locality: each trace is answered by search from the header
+// and by one cursor carried across the trace
+void benchmarkFingerSearch(int n, int lookups) {
+    vector<pair<int, int>> entries(n);
+    for (int i = 0; i < n; i++) {
+        entries[i] = make_pair(i * 2, i);
+    }
+    SkipList<int, int> list;
+    list.buildFromSorted(entries);
+    
+    mt19937 rng(11);
+    vector<int> sequential(lookups), nearlySorted(lookups), random(lookups);
+    for (int i = 0; i < lookups; i++) {
+        sequential[i] = static_cast<int>((i * 2ll) % (2ll * n));
+        random[i] = static_cast<int>(rng() % (2ull * n));
+    }
+    // Monotonic timestamps with jitter of up to 64 entries either way
+    for (int i = 0; i < lookups; i++) {
+        long long base = (i * 2ll) % (2ll * n);
+        long long jitter = static_cast<long long>(rng() % 257) - 128;
+        nearlySorted[i] = static_cast<int>(min(max(base + jitter, 0ll), 2ll * n - 1));
+    }
+    
+    auto time = [&](const vector<int>& trace, bool useCursor) {
+        auto c = list.makeCursor();
+        long long hits = 0;
+        auto start = chrono::steady_clock::now();
+        for (int key : trace) {
+            hits += useCursor ? c.find(key) != nullptr : list.search(key);
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / trace.size();
+        return make_pair(ns, hits);
+    };
+    
+    const pair<const char*, const vector<int>*> traces[] = {
+        {"sequential", &sequential}, {"nearly sorted", &nearlySorted}, {"random", &random}};
+    for (const auto& trace : traces) {
+        auto fromHeader = time(*trace.second, false);
+        auto withCursor = time(*trace.second, true);
+        cout << n << " keys, " << trace.first << ": search " << fromHeader.first << " ns/op, cursor "
+             << withCursor.first << " ns/op" << (fromHeader.second == withCursor.second ? "" : " (mismatch)") << endl;
+    }
+}
+
+
+// Loading n keys: one insert per key in random and sorted order, insertBatch
+// of the shuffled keys, and buildFromSorted
+void benchmarkBulkLoad(int n) {
+    vector<pair<int, int>> sorted(n);
+    for (int i = 0; i < n; i++) {
+        sorted[i] = make_pair(i * 2, i);
+    }
+    vector<pair<int, int>> shuffled = sorted;
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(7));
+    
+    auto ms = [](chrono::steady_clock::time_point a, chrono::steady_clock::time_point b) {
+        return chrono::duration<double, milli>(b - a).count();
+    };
+    
+    auto t0 = chrono::steady_clock::now();
+    {
+        SkipList<int, int> list;
+        for (const auto& kv : shuffled) {
+            list.insert(kv.first, kv.second);
+        }
+    }
+    auto t1 = chrono::steady_clock::now();
+    {
+        SkipList<int, int> list;
+        for (const auto& kv : sorted) {
+            list.insert(kv.first, kv.second);
+        }
+    }
+    auto t2 = chrono::steady_clock::now();
+    {
+        SkipList<int, int> list;
+        list.insertBatch(shuffled);
+    }
+    auto t3 = chrono::steady_clock::now();
+    {
+        SkipList<int, int> list;
+        list.buildFromSorted(sorted);
+    }
+    auto t4 = chrono::steady_clock::now();
+    
+    cout << n << " keys: insert random " << ms(t0, t1) << " ms, insert sorted " << ms(t1, t2)
+         << " ms, insertBatch " << ms(t2, t3) << " ms, buildFromSorted " << ms(t3, t4) << " ms" << endl;
+}
+
+
+// Sum of the values in time windows: one range scan per window vs a point
+// lookup for every timestamp the window could contain
+void benchmarkRangeSum(int n, int width, int queries) {
+    vector<pair<int, long long>> source(n);
+    for (int i = 0; i < n; i++) {
+        source[i] = make_pair(i * 4, i % 100);
+    }
+    SkipList<int, long long> events;
+    events.buildFromSorted(source);
+    
+    uint64_t state = 88172645463325252ull;
+    vector<int> starts(queries);
+    for (int& start : starts) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        start = static_cast<int>(state % (4ull * n));
+    }
+    
+    long long scanned = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int start : starts) {
+        scanned += events.rangeSum(start, start + width);
+    }
+    auto t1 = chrono::steady_clock::now();
+    long long looked = 0;
+    for (int start : starts) {
+        for (int t = start; t < start + width; t++) {
+            if (long long* value = events.find(t)) {
+                looked += *value;
+            }
+        }
+    }
+    auto t2 = chrono::steady_clock::now();
+    
+    cout << "window " << width << ": rangeSum " << chrono::duration<double, micro>(t1 - t0).count() / queries
+         << " us/query, point lookups " << chrono::duration<double, micro>(t2 - t1).count() / queries
+         << " us/query" << (scanned == looked ? "" : " (mismatch)") << endl;
+}
+
+
+void runBenchmarks(const vector<int>& sizes) {
+    cout << "Search latency, random keys:" << endl;
+    for (int n : sizes) {
+        benchmarkSearchLatency(n, 1000000);
+    }
+    cout << endl;
+    
+    cout << "Finger search:" << endl;
+    for (int n : sizes) {
+        benchmarkFingerSearch(n, 1000000);
+    }
+    cout << endl;
+    
+    cout << "Bulk loading:" << endl;
+    benchmarkBulkLoad(1000000);
+    cout << endl;
+    
+    cout << "Range sums over 1000000 timestamped events:" << endl;
+    for (int width : {64, 4096}) {
+        benchmarkRangeSum(1000000, width, 2000);
+    }
+    cout << endl;
+    
+    const int keySpace = 1 << 20;
+    const int opsPerThread = 500000;
+    int maxThreads = max(4, static_cast<int>(thread::hardware_concurrency()));
+    
+    cout << "Mixed workload throughput (Mops/s), " << keySpace << " keys:" << endl;
+    for (int searchPercent : {90, 50}) {
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            ConcurrentSkipList<int> lockFree;
+            LockedSet locked;
+            for (int i = 0; i < keySpace; i += 2) {
+                lockFree.insert(i);
+                locked.insert(i);
+            }
+            cout << searchPercent << "% search, " << threads << " threads: "
+                 << "lock-free " << benchmarkMixed(lockFree, threads, searchPercent, opsPerThread, keySpace)
+                 << ", std::set + mutex " << benchmarkMixed(locked, threads, searchPercent, opsPerThread, keySpace)
+                 << endl;
+        }
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        vector<int> sizes;
+        for (int i = 2; i < argc; i++) {
+            sizes.push_back(atoi(argv[i]));
+        }
+        if (sizes.empty()) {
+            sizes = {1000000, 10000000};
+        }
+        runBenchmarks(sizes);
+        return 0;
+    }
+    
+    SkipList<int, int> list;
+    
+    
+    for (int key : {3, 6, 7, 9, 12, 19, 17, 26, 21, 25}) {
+        if (list.insert(key)) {
+            cout << "Successfully inserted key " << key << endl;
+        }
+    }
     
     
     list.display();
@@ -229,12 +1235,56 @@ int main() {
     cout << "Searching for 20: " << (list.search(20) ? "Found" : "Not Found") << endl;
     
     
-    list.remove(19);
-    list.remove(20);
+    for (int key : {19, 20}) {
+        if (list.remove(key)) {
+            cout << "Successfully deleted key " << key << endl;
+        } else {
+            cout << "Key " << key << " not found in the list" << endl;
+        }
+    }
     
     
     
     list.display();
     
+    
+    vector<pair<int, int>> counts;
+    for (int t = 0; t < 100; t += 10) {
+        counts.push_back(make_pair(t, t / 10 + 1));
+    }
+    SkipList<int, int> buckets;
+    buckets.buildFromSorted(counts);
+    
+    cout << "\nBuckets from 35:";
+    for (auto it = buckets.lower_bound(35); it != buckets.end(); ++it) {
+        cout << " " << it->key << "=" << it->value;
+    }
+    cout << endl;
+    auto finger = buckets.makeCursor();
+    cout << "Cursor at 40, then 70: " << *finger.find(40) << " " << *finger.find(70) << endl;
+    cout << "Count in [20, 60): " << buckets.rangeCount(20, 60) << endl;
+    cout << "Sum in [20, 60): " << buckets.rangeSum(20, 60) << endl;
+    
+    
+    ConcurrentSkipList<int> shared;
+    vector<thread> workers;
+    for (int t = 0; t < 4; t++) {
+        workers.emplace_back([&shared, t]() {
+            for (int key = t; key < 1000; key += 4) {
+                shared.insert(key);
+            }
+            for (int key = t; key < 1000; key += 8) {
+                shared.remove(key);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    cout << "\nConcurrent skip list holds " << shared.size() << " keys" << endl;
+    cout << "Searching for 4: " << (shared.search(4) ? "Found" : "Not Found") << endl;
+    cout << "Searching for 5: " << (shared.search(5) ? "Found" : "Not Found") << endl;
+    
     return 0;
 }
\ No newline at end of file
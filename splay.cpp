@@ -3,6 +3,20 @@
 
 
 #include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 using namespace std;
 
@@ -16,15 +30,34 @@ public:
     Node(int k) : key(k), left(nullptr), right(nullptr) {}
 };
 
+// BOTTOM_UP is the original recursive splay, whose recursion is as deep as
+// the access path. TOP_DOWN splays iteratively in one pass. SEMI_SPLAY
+// splays like TOP_DOWN on updates, but a search only semi-splays the path:
+// a zig-zig rotates just the parent, and nothing within semiDepth of the
+// root is moved, so hot keys near the top are read without any writes.
+enum SplayMode {
+    BOTTOM_UP,
+    TOP_DOWN,
+    SEMI_SPLAY
+};
+
+
 class SplayTree {
 private:
     Node* root;
+    SplayMode mode;
+    int semiDepth;
+    long long linkWrites;
+    
+    // Links from the root to the last searched node, reused across searches
+    vector<Node**> path;
     
     
     Node* rightRotate(Node* x) {
         Node* y = x->left;
         x->left = y->right;
         y->right = x;
+        linkWrites += 3;
         return y;
     }
     
@@ -33,10 +66,16 @@ private:
         Node* y = x->right;
         x->right = y->left;
         y->left = x;
+        linkWrites += 3;
         return y;
     }
     
     
+    Node* rotateUp(Node* parent, Node* child) {
+        return parent->left == child ? rightRotate(parent) : leftRotate(parent);
+    }
+    
+    
     Node* splay(Node* root, int key) {
         
         if (root == nullptr || root->key == key) {
@@ -104,8 +143,109 @@ private:
     }
     
     
-    Node* search(Node* root, int key) {
-        return splay(root, key);
+    // Splay in a single pass down the tree. Nodes passed on the way go to a
+    // left tree (smaller keys) or a right tree (larger keys), which are hung
+    // under the new root at the end.
+    Node* splayTopDown(Node* root, int key) {
+        if (root == nullptr) {
+            return root;
+        }
+        
+        Node assembly(0);
+        Node* leftMax = &assembly;
+        Node* rightMin = &assembly;
+        
+        
+        for (;;) {
+            if (key < root->key) {
+                if (root->left == nullptr) {
+                    break;
+                }
+                if (key < root->left->key) {
+                    root = rightRotate(root);
+                    if (root->left == nullptr) {
+                        break;
+                    }
+                }
+                rightMin->left = root;
+                rightMin = root;
+                linkWrites++;
+                root = root->left;
+            } else if (key > root->key) {
+                if (root->right == nullptr) {
+                    break;
+                }
+                if (key > root->right->key) {
+                    root = leftRotate(root);
+                    if (root->right == nullptr) {
+                        break;
+                    }
+                }
+                leftMax->right = root;
+                leftMax = root;
+                linkWrites++;
+                root = root->right;
+            } else {
+                break;
+            }
+        }
+        
+        
+        leftMax->right = root->left;
+        rightMin->left = root->right;
+        root->left = assembly.right;
+        root->right = assembly.left;
+        linkWrites += 4;
+        return root;
+    }
+    
+    
+    // Semi-splay the last node on the path to key, returning whether key
+    // was found. Each step moves the node being splayed up by two levels.
+    bool semiSplay(int key) {
+        path.clear();
+        Node** link = &root;
+        while (*link != nullptr) {
+            path.push_back(link);
+            if (key == (*link)->key) {
+                break;
+            }
+            link = key < (*link)->key ? &(*link)->left : &(*link)->right;
+        }
+        
+        if (path.empty()) {
+            return false;
+        }
+        bool found = (*path.back())->key == key;
+        
+        
+        // path[i] is at depth i, and each step rewrites the link to the
+        // grandparent at depth i - 2, so stop before that reaches semiDepth
+        int i = static_cast<int>(path.size()) - 1;
+        while (i >= 2 && i - 2 >= semiDepth) {
+            Node* node = *path[i];
+            Node* parent = *path[i - 1];
+            Node** grandparentLink = path[i - 2];
+            Node* grandparent = *grandparentLink;
+            
+            if ((grandparent->left == parent) == (parent->left == node)) {
+                *grandparentLink = rotateUp(grandparent, parent);
+            } else {
+                *path[i - 1] = rotateUp(parent, node);
+                *grandparentLink = rotateUp(grandparent, node);
+            }
+            i -= 2;
+        }
+        if (i == 1 && semiDepth == 0) {
+            *path[0] = rotateUp(*path[0], *path[1]);
+        }
+        
+        return found;
+    }
+    
+    
+    Node* splay(Node* root, int key, SplayMode how) {
+        return how == BOTTOM_UP ? splay(root, key) : splayTopDown(root, key);
     }
     
     
@@ -116,7 +256,7 @@ private:
         }
         
         
-        root = splay(root, key);
+        root = splay(root, key, mode);
         
         
         if (root->key == key) {
@@ -151,7 +291,7 @@ private:
         }
         
         
-        root = splay(root, key);
+        root = splay(root, key, mode);
         
         
         if (root->key != key) {
@@ -172,7 +312,7 @@ private:
             
             
             root = root->left;
-            root = splay(root, key);
+            root = splay(root, key, mode);
             root->right = temp->right;
         }
         
@@ -204,36 +344,57 @@ private:
     }
     
     
+    // Rotate left children up until the root has none, then delete it and
+    // move right: O(n) with no recursion, however deep the tree is
     void clear(Node* root) {
-        if (root == nullptr) {
-            return;
+        while (root != nullptr) {
+            if (root->left != nullptr) {
+                Node* left = root->left;
+                root->left = left->right;
+                left->right = root;
+                root = left;
+            } else {
+                Node* right = root->right;
+                delete root;
+                root = right;
+            }
         }
-        
-        clear(root->left);
-        clear(root->right);
-        delete root;
     }
     
 public:
-    SplayTree() : root(nullptr) {}
+    explicit SplayTree(SplayMode m = TOP_DOWN, int depth = 4)
+        : root(nullptr), mode(m), semiDepth(m == SEMI_SPLAY ? depth : 0), linkWrites(0) {}
     
     ~SplayTree() {
         clear(root);
     }
     
+    SplayTree(const SplayTree&) = delete;
+    SplayTree& operator=(const SplayTree&) = delete;
+    
     
     void insert(int key) {
         root = insert(root, key);
     }
     
     
-    void search(int key) {
-        root = search(root, key);
-        if (root->key == key) {
-            cout << "Key " << key << " found in the tree" << endl;
-        } else {
-            cout << "Key " << key << " not found in the tree" << endl;
+    // Look key up without restructuring, so concurrent readers can share it
+    bool contains(int key) const {
+        Node* current = root;
+        while (current != nullptr && current->key != key) {
+            current = key < current->key ? current->left : current->right;
         }
+        return current != nullptr;
+    }
+    
+    
+    bool search(int key) {
+        if (mode == SEMI_SPLAY) {
+            return semiSplay(key);
+        }
+        
+        root = splay(root, key, mode);
+        return root != nullptr && root->key == key;
     }
     
     
@@ -263,10 +424,748 @@ public:
         }
         return root->key;
     }
+    
+    
+    // Child pointers written while splaying, counting three per rotation
+    long long getLinkWrites() {
+        return linkWrites;
+    }
 };
 
 
-int main() {
+// SplayTree shared between threads. Readers look keys up without splaying
+// and log each key in a buffer of their own. A maintenance thread drains the
+// buffers every interval and replays the splays in short exclusive batches,
+// so the shape still follows the access pattern, just a little behind. A
+// full buffer drops further keys until the next drain, which only loses
+// samples.
+//
+// There is no shared reader lock: each thread announces its reads in a flag
+// on its own buffer's cache line, and a writer raises writerActive, then
+// waits for every flag to clear. Readers only ever read the shared line, so
+// they scale until a writer shows up. A thread's buffer is freed by the
+// next drain after the thread exits.
+class ConcurrentSplayTree {
+private:
+    static const int REPLAY_BATCH = 256;
+    
+    struct alignas(64) AccessBuffer {
+        atomic<bool> reading{false};
+        // Set when the thread exits or the tree goes away, whichever is first
+        atomic<bool> exited{false};
+        atomic<bool> orphaned{false};
+        uint64_t owner;
+        mutex lock;
+        vector<int> keys;
+        unsigned skipped = 0;
+    };
+    
+    // The buffers of one thread, one per tree it has read; marking them on
+    // exit lets each tree free its own
+    struct ThreadBuffers {
+        vector<shared_ptr<AccessBuffer>> buffers;
+        AccessBuffer* last = nullptr;
+        
+        ~ThreadBuffers() {
+            for (auto& buffer : buffers) {
+                buffer->exited.store(true, memory_order_release);
+            }
+        }
+    };
+    
+    SplayTree tree;
+    
+    // Writers take writeLock, then hold readers back with writerActive, so
+    // a steady stream of overlapping reads cannot starve updates or replays
+    mutex writeLock;
+    atomic<bool> writerActive;
+    
+    uint64_t id;
+    size_t bufferCapacity;
+    unsigned sampleEvery;
+    mutex buffersLock;
+    vector<shared_ptr<AccessBuffer>> buffers;
+    
+    chrono::milliseconds interval;
+    mutex stopLock;
+    condition_variable stopSignal;
+    bool stopping;
+    thread maintenance;
+    
+    
+    AccessBuffer& localBuffer() {
+        static thread_local ThreadBuffers local;
+        // Ids are never reused, so a stale pointer cannot match
+        if (local.last != nullptr && local.last->owner == id) {
+            return *local.last;
+        }
+        
+        size_t kept = 0;
+        AccessBuffer* found = nullptr;
+        for (auto& buffer : local.buffers) {
+            if (buffer->orphaned.load(memory_order_acquire)) {
+                continue;
+            }
+            if (buffer->owner == id) {
+                found = buffer.get();
+            }
+            local.buffers[kept++] = buffer;
+        }
+        local.buffers.resize(kept);
+        
+        if (found == nullptr) {
+            shared_ptr<AccessBuffer> buffer(new AccessBuffer());
+            buffer->owner = id;
+            buffer->keys.reserve(bufferCapacity);
+            {
+                lock_guard<mutex> guard(buffersLock);
+                buffers.push_back(buffer);
+            }
+            local.buffers.push_back(buffer);
+            found = buffer.get();
+        }
+        local.last = found;
+        return *found;
+    }
+    
+    
+    template<typename F>
+    void exclusive(F update) {
+        lock_guard<mutex> guard(writeLock);
+        writerActive.store(true, memory_order_seq_cst);
+        {
+            // A reader that raised its flag after this scan sees writerActive
+            // and backs off, so only the ones already inside are waited for
+            lock_guard<mutex> listGuard(buffersLock);
+            for (auto& buffer : buffers) {
+                while (buffer->reading.load(memory_order_seq_cst)) {
+                    this_thread::yield();
+                }
+            }
+        }
+        update();
+        writerActive.store(false, memory_order_release);
+    }
+    
+    
+    static uint64_t nextId() {
+        static atomic<uint64_t> ids(1);
+        return ids.fetch_add(1, memory_order_relaxed);
+    }
+    
+public:
+    explicit ConcurrentSplayTree(chrono::milliseconds replayInterval = chrono::milliseconds(10),
+                                 size_t keysPerThread = 4096, unsigned logOneIn = 1)
+        : tree(TOP_DOWN), writerActive(false), id(nextId()), bufferCapacity(keysPerThread),
+          sampleEvery(max(logOneIn, 1u)), interval(replayInterval), stopping(false) {
+        maintenance = thread([this]() {
+            unique_lock<mutex> guard(stopLock);
+            while (!stopSignal.wait_for(guard, interval, [this]() { return stopping; })) {
+                guard.unlock();
+                replayAccesses();
+                guard.lock();
+            }
+        });
+    }
+    
+    ~ConcurrentSplayTree() {
+        {
+            lock_guard<mutex> guard(stopLock);
+            stopping = true;
+        }
+        stopSignal.notify_one();
+        maintenance.join();
+        
+        // Threads still holding our buffers drop them on their next lookup
+        lock_guard<mutex> guard(buffersLock);
+        for (auto& buffer : buffers) {
+            buffer->orphaned.store(true, memory_order_release);
+        }
+    }
+    
+    ConcurrentSplayTree(const ConcurrentSplayTree&) = delete;
+    ConcurrentSplayTree& operator=(const ConcurrentSplayTree&) = delete;
+    
+    
+    bool search(int key) {
+        AccessBuffer& buffer = localBuffer();
+        while (true) {
+            buffer.reading.store(true, memory_order_seq_cst);
+            if (!writerActive.load(memory_order_seq_cst)) {
+                break;
+            }
+            buffer.reading.store(false, memory_order_release);
+            while (writerActive.load(memory_order_acquire)) {
+                this_thread::yield();
+            }
+        }
+        bool found = tree.contains(key);
+        buffer.reading.store(false, memory_order_release);
+        
+        // Logging one read in sampleEvery keeps the frequencies while
+        // taking the buffer lock less often
+        if (++buffer.skipped < sampleEvery) {
+            return found;
+        }
+        buffer.skipped = 0;
+        
+        lock_guard<mutex> guard(buffer.lock);
+        if (buffer.keys.size() < bufferCapacity) {
+            buffer.keys.push_back(key);
+        }
+        return found;
+    }
+    
+    
+    void insert(int key) {
+        exclusive([&]() { tree.insert(key); });
+    }
+    
+    void remove(int key) {
+        exclusive([&]() { tree.remove(key); });
+    }
+    
+    
+    // Splay everything logged since the last call, and free the buffers of
+    // threads that have exited; the maintenance thread runs this every
+    // interval
+    void replayAccesses() {
+        vector<int> pending;
+        {
+            lock_guard<mutex> guard(buffersLock);
+            size_t kept = 0;
+            for (auto& buffer : buffers) {
+                {
+                    lock_guard<mutex> bufferGuard(buffer->lock);
+                    pending.insert(pending.end(), buffer->keys.begin(), buffer->keys.end());
+                    buffer->keys.clear();
+                }
+                if (!buffer->exited.load(memory_order_acquire)) {
+                    buffers[kept++] = buffer;
+                }
+            }
+            buffers.resize(kept);
+        }
+        
+        for (size_t start = 0; start < pending.size(); start += REPLAY_BATCH) {
+            size_t end = min(pending.size(), start + REPLAY_BATCH);
+            exclusive([&]() {
+                for (size_t i = start; i < end; i++) {
+                    tree.search(pending[i]);
+                }
+            });
+        }
+    }
+    
+    
+    // Threads whose access buffers the tree still holds
+    size_t registeredThreads() {
+        lock_guard<mutex> guard(buffersLock);
+        return buffers.size();
+    }
+};
+
+
+template<typename K, typename V>
+class CacheNode {
+public:
+    K key;
+    V value;
+    CacheNode* left;
+    CacheNode* right;
+    
+    CacheNode(const K& k, const V& v) : key(k), value(v), left(nullptr), right(nullptr) {}
+};
+
+
+// Bounded key/value cache on a splay tree. Every get or put splays its key
+// to the root, so recently used entries stay near the top and cold ones
+// sink. When full, the deepest of a few random root-to-leaf walks picks the
+// entry to evict: a leaf is the least recently splayed node on its path, and
+// removing one needs no restructuring. Its node is reused for the new entry.
+// More samples evict colder entries but cost a walk each.
+template<typename K, typename V>
+class SplayCache {
+private:
+    typedef CacheNode<K, V> NodeType;
+    
+    NodeType* root;
+    size_t count;
+    size_t limit;
+    int samples;
+    uint64_t rngState;
+    
+    
+    // Top-down splay as in SplayTree, also ending at the last node on the
+    // path when key is missing
+    NodeType* splay(NodeType* t, const K& key) {
+        if (t == nullptr) {
+            return t;
+        }
+        
+        NodeType* leftTree = nullptr;
+        NodeType* rightTree = nullptr;
+        NodeType** leftTail = &leftTree;
+        NodeType** rightTail = &rightTree;
+        
+        
+        for (;;) {
+            if (key < t->key) {
+                if (t->left == nullptr) {
+                    break;
+                }
+                if (key < t->left->key) {
+                    NodeType* y = t->left;
+                    t->left = y->right;
+                    y->right = t;
+                    t = y;
+                    if (t->left == nullptr) {
+                        break;
+                    }
+                }
+                *rightTail = t;
+                rightTail = &t->left;
+                t = t->left;
+            } else if (t->key < key) {
+                if (t->right == nullptr) {
+                    break;
+                }
+                if (t->right->key < key) {
+                    NodeType* y = t->right;
+                    t->right = y->left;
+                    y->left = t;
+                    t = y;
+                    if (t->right == nullptr) {
+                        break;
+                    }
+                }
+                *leftTail = t;
+                leftTail = &t->right;
+                t = t->right;
+            } else {
+                break;
+            }
+        }
+        
+        
+        *leftTail = t->left;
+        *rightTail = t->right;
+        t->left = leftTree;
+        t->right = rightTree;
+        return t;
+    }
+    
+    
+    uint64_t nextRandom() {
+        rngState ^= rngState << 13;
+        rngState ^= rngState >> 7;
+        rngState ^= rngState << 17;
+        return rngState;
+    }
+    
+    
+    // Walk from the root to a leaf, taking a random child wherever there
+    // are two, and return the link to it and its depth
+    NodeType** randomLeaf(int& depth) {
+        NodeType** link = &root;
+        uint64_t bits = nextRandom();
+        depth = 0;
+        
+        
+        for (;;) {
+            NodeType* node = *link;
+            if (node->left == nullptr && node->right == nullptr) {
+                return link;
+            }
+            
+            if (depth % 64 == 63) {
+                bits = nextRandom();
+            }
+            if (node->right == nullptr || (node->left != nullptr && (bits >> (depth % 64) & 1))) {
+                link = &node->left;
+            } else {
+                link = &node->right;
+            }
+            depth++;
+        }
+    }
+    
+    
+    // Unlink the deepest of a few random leaves
+    NodeType* evictLeaf() {
+        int bestDepth;
+        NodeType** best = randomLeaf(bestDepth);
+        for (int i = 1; i < samples; i++) {
+            int depth;
+            NodeType** link = randomLeaf(depth);
+            if (depth > bestDepth) {
+                best = link;
+                bestDepth = depth;
+            }
+        }
+        
+        NodeType* leaf = *best;
+        *best = nullptr;
+        count--;
+        return leaf;
+    }
+    
+public:
+    explicit SplayCache(size_t capacity, int evictionSamples = 2)
+        : root(nullptr), count(0), limit(max<size_t>(capacity, 1)), samples(max(evictionSamples, 1)),
+          rngState(0x9E3779B97F4A7C15ull) {}
+    
+    // Flatten by rotating left children up, as SplayTree::clear does
+    ~SplayCache() {
+        while (root != nullptr) {
+            if (root->left != nullptr) {
+                NodeType* left = root->left;
+                root->left = left->right;
+                left->right = root;
+                root = left;
+            } else {
+                NodeType* right = root->right;
+                delete root;
+                root = right;
+            }
+        }
+    }
+    
+    SplayCache(const SplayCache&) = delete;
+    SplayCache& operator=(const SplayCache&) = delete;
+    
+    
+    // The cached value, or nullptr on a miss
+    V* get(const K& key) {
+        root = splay(root, key);
+        return root != nullptr && !(root->key < key) && !(key < root->key) ? &root->value : nullptr;
+    }
+    
+    
+    void put(const K& key, const V& value) {
+        root = splay(root, key);
+        if (root != nullptr && !(root->key < key) && !(key < root->key)) {
+            root->value = value;
+            return;
+        }
+        
+        
+        NodeType* node;
+        if (count == limit) {
+            node = evictLeaf();
+            node->key = key;
+            node->value = value;
+            node->left = node->right = nullptr;
+        } else {
+            node = new NodeType(key, value);
+        }
+        
+        
+        // The leaf taken was never the root unless it was the only node, so
+        // the splayed root still splits the tree around key
+        if (root != nullptr) {
+            if (key < root->key) {
+                node->right = root;
+                node->left = root->left;
+                root->left = nullptr;
+            } else {
+                node->left = root;
+                node->right = root->right;
+                root->right = nullptr;
+            }
+        }
+        root = node;
+        count++;
+    }
+    
+    
+    size_t size() {
+        return count;
+    }
+    
+    size_t capacity() {
+        return limit;
+    }
+};
+
+
+// Hash map plus recency list, the usual LRU cache, for comparison
+template<typename K, typename V>
+class LRUCache {
+private:
+    typedef list<pair<K, V>> Entries;
+    
+    Entries entries;
+    unordered_map<K, typename Entries::iterator> index;
+    size_t limit;
+    
+public:
+    explicit LRUCache(size_t capacity) : limit(max<size_t>(capacity, 1)) {
+        index.reserve(limit);
+    }
+    
+    V* get(const K& key) {
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return nullptr;
+        }
+        entries.splice(entries.begin(), entries, it->second);
+        return &it->second->second;
+    }
+    
+    void put(const K& key, const V& value) {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = value;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        
+        if (entries.size() == limit) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+        entries.emplace_front(key, value);
+        index[key] = entries.begin();
+    }
+};
+
+
+// Keys 0..n-1 in a random order with Zipf(s) popularity by position
+class ZipfTrace {
+private:
+    vector<double> cdf;
+    vector<int> keys;
+    mt19937 rng;
+    uniform_real_distribution<double> unit;
+    
+public:
+    ZipfTrace(int n, double s, unsigned seed) : cdf(n), keys(n), rng(seed), unit(0.0, 1.0) {
+        double total = 0;
+        for (int i = 0; i < n; i++) {
+            total += 1.0 / pow(i + 1.0, s);
+            cdf[i] = total;
+        }
+        for (double& c : cdf) {
+            c /= total;
+        }
+        for (int i = 0; i < n; i++) {
+            keys[i] = i;
+        }
+        shuffle(keys.begin(), keys.end(), rng);
+    }
+    
+    int next() {
+        size_t rank = lower_bound(cdf.begin(), cdf.end(), unit(rng)) - cdf.begin();
+        return keys[min(rank, keys.size() - 1)];
+    }
+};
+
+
+// n shuffled keys, then a trace of searches in each mode; reports the time
+// and the pointer writes per search
+void benchmarkTrace(const char* name, int n, const vector<int>& trace) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(3));
+    
+    cout << name << ", " << n << " keys:";
+    const pair<const char*, SplayMode> modes[] = {
+        {"bottom-up", BOTTOM_UP}, {"top-down", TOP_DOWN}, {"semi-splay", SEMI_SPLAY}};
+    for (const auto& m : modes) {
+        SplayTree tree(m.second);
+        for (int key : keys) {
+            tree.insert(key);
+        }
+        
+        long long before = tree.getLinkWrites();
+        long long hits = 0;
+        auto start = chrono::steady_clock::now();
+        for (int key : trace) {
+            hits += tree.search(key);
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / trace.size();
+        double perSearch = static_cast<double>(tree.getLinkWrites() - before) / trace.size();
+        cout << " " << m.first << " " << ns << " ns (" << perSearch << " writes)"
+             << (hits == static_cast<long long>(trace.size()) ? "" : " (missed)");
+    }
+    cout << endl;
+}
+
+
+// Read-through caching of a skewed trace: a miss puts the key
+template<typename Cache>
+pair<double, double> replay(Cache& cache, const vector<int>& trace) {
+    long long hits = 0;
+    auto start = chrono::steady_clock::now();
+    for (int key : trace) {
+        if (cache.get(key) != nullptr) {
+            hits++;
+        } else {
+            cache.put(key, key);
+        }
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / trace.size();
+    return make_pair(100.0 * hits / trace.size(), ns);
+}
+
+
+void benchmarkCaches(int n, double skew, size_t capacity) {
+    ZipfTrace zipf(n, skew, 21);
+    vector<int> trace(4000000);
+    for (int& key : trace) {
+        key = zipf.next();
+    }
+    
+    cout << "Zipf " << skew << " over " << n << " keys, capacity " << capacity << ":";
+    for (int samples : {1, 2, 4}) {
+        SplayCache<int, int> splayCache(capacity, samples);
+        auto splayed = replay(splayCache, trace);
+        cout << " splay cache (" << samples << " samples) " << splayed.first << "% hits, " << splayed.second << " ns/op;";
+    }
+    
+    LRUCache<int, int> lruCache(capacity);
+    auto lru = replay(lruCache, trace);
+    cout << " LRU hash map " << lru.first << "% hits, " << lru.second << " ns/op" << endl;
+}
+
+
+// Zipf lookups on n keys from several threads: a SplayTree behind a mutex,
+// splaying on every read, against ConcurrentSplayTree with deferred splays
+// and with replay effectively switched off (a static random BST)
+void benchmarkConcurrentReads(int n, int threads, int lookupsPerThread) {
+    vector<int> keys(n);
+    for (int i = 0; i < n; i++) {
+        keys[i] = i;
+    }
+    shuffle(keys.begin(), keys.end(), mt19937(3));
+    
+    vector<vector<int>> traces(threads);
+    for (int t = 0; t < threads; t++) {
+        ZipfTrace zipf(n, 0.99, 40 + t);
+        traces[t].resize(lookupsPerThread);
+        for (int& key : traces[t]) {
+            key = zipf.next();
+        }
+    }
+    
+    auto run = [&](auto search) {
+        vector<thread> workers;
+        auto start = chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t]() {
+                for (int key : traces[t]) {
+                    search(key);
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return static_cast<double>(threads) * lookupsPerThread / seconds / 1e6;
+    };
+    
+    
+    SplayTree locked;
+    mutex lock;
+    for (int key : keys) {
+        locked.insert(key);
+    }
+    double lockedRate = run([&](int key) {
+        lock_guard<mutex> guard(lock);
+        return locked.search(key);
+    });
+    
+    ConcurrentSplayTree deferred;
+    for (int key : keys) {
+        deferred.insert(key);
+    }
+    double deferredRate = run([&](int key) { return deferred.search(key); });
+    
+    ConcurrentSplayTree sampled(chrono::milliseconds(10), 4096, 8);
+    for (int key : keys) {
+        sampled.insert(key);
+    }
+    double sampledRate = run([&](int key) { return sampled.search(key); });
+    
+    ConcurrentSplayTree frozen(chrono::hours(1));
+    for (int key : keys) {
+        frozen.insert(key);
+    }
+    frozen.replayAccesses();
+    double frozenRate = run([&](int key) { return frozen.search(key); });
+    
+    cout << n << " keys, " << threads << " threads (Mlookups/s): splay + mutex " << lockedRate
+         << ", deferred splays " << deferredRate << ", deferred 1 in 8 " << sampledRate
+         << ", no splays " << frozenRate << endl;
+}
+
+
+void runBenchmarks(const vector<int>& sizes) {
+    for (int n : sizes) {
+        const int searches = 2000000;
+        
+        ZipfTrace zipf(n, 0.99, 9);
+        vector<int> skewed(searches);
+        for (int& key : skewed) {
+            key = zipf.next();
+        }
+        benchmarkTrace("Zipf 0.99", n, skewed);
+        
+        // One pass only: afterwards the tree is a path of depth n, which the
+        // recursive splay cannot walk back down without overflowing the stack
+        vector<int> sequential(n);
+        for (int i = 0; i < n; i++) {
+            sequential[i] = i;
+        }
+        benchmarkTrace("sequential", n, sequential);
+    }
+    
+    
+    // Ascending inserts leave a path of depth n behind; searching its far
+    // end would overflow the stack in the recursive splay
+    int n = sizes.back();
+    SplayTree chain(TOP_DOWN);
+    auto start = chrono::steady_clock::now();
+    for (int key = 0; key < n; key++) {
+        chain.insert(key);
+    }
+    bool found = chain.search(0);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "top-down, " << n << " ascending inserts then search(0): " << seconds << " s"
+         << (found ? "" : " (missed)") << endl;
+    
+    
+    unsigned maxThreads = max(4u, thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        benchmarkConcurrentReads(n, threads, 1000000);
+    }
+    
+    
+    for (double skew : {0.8, 0.99, 1.2}) {
+        for (size_t capacity : {static_cast<size_t>(n / 100), static_cast<size_t>(n / 10)}) {
+            benchmarkCaches(n, skew, capacity);
+        }
+    }
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "bench") {
+        vector<int> sizes;
+        for (int i = 2; i < argc; i++) {
+            sizes.push_back(atoi(argv[i]));
+        }
+        if (sizes.empty()) {
+            sizes = {100000, 1000000};
+        }
+        runBenchmarks(sizes);
+        return 0;
+    }
+    
     SplayTree tree;
     
     
@@ -281,7 +1180,7 @@ int main() {
     tree.printInOrder();
     
     
-    tree.search(30);
+    cout << "Key 30 " << (tree.search(30) ? "found" : "not found") << " in the tree" << endl;
     cout << "After searching 30, root is: " << tree.getRootKey() << endl;
     tree.printInOrder();
     
@@ -291,9 +1190,51 @@ int main() {
     tree.printInOrder();
     
     
-    tree.search(25);
+    cout << "Key 25 " << (tree.search(25) ? "found" : "not found") << " in the tree" << endl;
     cout << "After searching 25, root is: " << tree.getRootKey() << endl;
     tree.printInOrder();
     
+    
+    // Ascending inserts leave a left spine, so key 10 - d sits at depth d.
+    // Reading the key just below semiDepth must not move anything above it.
+    SplayTree semi(SEMI_SPLAY, 4);
+    for (int key = 1; key <= 10; key++) {
+        semi.insert(key);
+    }
+    long long writes = semi.getLinkWrites();
+    semi.search(5);
+    semi.search(5);
+    cout << "Semi-splay reads at depth 5 wrote " << semi.getLinkWrites() - writes << " links" << endl;
+    
+    
+    SplayCache<string, int> cache(2);
+    cache.put("alpha", 1);
+    cache.put("beta", 2);
+    cache.put("gamma", 3);
+    int* gamma = cache.get("gamma");
+    cout << "Cache holds " << cache.size() << " of " << cache.capacity() << " entries, gamma = "
+         << (gamma != nullptr ? to_string(*gamma) : "missing") << endl;
+    
+    
+    ConcurrentSplayTree shared;
+    for (int key = 0; key < 1000; key++) {
+        shared.insert(key);
+    }
+    atomic<int> hits(0);
+    vector<thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&shared, &hits, t]() {
+            for (int key = t; key < 2000; key += 4) {
+                hits += shared.search(key);
+            }
+        });
+    }
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    cout << "Concurrent readers found " << hits << " of 2000 keys" << endl;
+    shared.replayAccesses();
+    cout << "Reader buffers left after the readers exited: " << shared.registeredThreads() << endl;
+    
     return 0;
 }
\ No newline at end of file